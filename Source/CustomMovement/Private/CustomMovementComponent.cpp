@@ -5,7 +5,11 @@
 #endif
 
 #include "AbilitySystemBlueprintLibrary.h"
+#include "AbilitySystemComponent.h"
+#include "Async/ParallelFor.h"
+#include "Engine/OverlapResult.h"
 #include "GameFramework/Character.h"
+#include "GameFramework/PlayerState.h"
 #include "Tags/CM_GameplayTags.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(CustomMovementComponent)
@@ -35,6 +39,45 @@ namespace PredMovementCVars
 #endif
 }
 
+namespace CustomMovementModifiers
+{
+	/** Indexes the level tags, appending any tag in the params map that isn't a level yet */
+	template<typename TLevel, typename TParams>
+	static void RebuildLevels(TArray<FGameplayTag>& LevelTags, TModifierLevelIndex<TLevel>& LevelIndex, const TMap<FGameplayTag, TParams>& ParamsMap)
+	{
+		LevelIndex.Rebuild(LevelTags);
+
+		const int32 NumLevels = LevelTags.Num();
+		for (const auto& Level : ParamsMap)
+		{
+			if (!LevelIndex.Contains(Level.Key))
+			{
+				LevelTags.Add(Level.Key);
+			}
+		}
+
+		if (LevelTags.Num() != NumLevels)
+		{
+			LevelIndex.Rebuild(LevelTags);
+		}
+	}
+
+	/** The number of levels RebuildLevels results in, without rebuilding them */
+	template<typename TParams>
+	static int32 CountLevels(const TArray<FGameplayTag>& LevelTags, const TMap<FGameplayTag, TParams>& ParamsMap)
+	{
+		int32 NumLevels = LevelTags.Num();
+		for (const auto& Level : ParamsMap)
+		{
+			if (!LevelTags.Contains(Level.Key))
+			{
+				NumLevels++;
+			}
+		}
+		return NumLevels;
+	}
+}
+
 UCustomMovementComponent::UCustomMovementComponent(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
@@ -98,16 +141,121 @@ UCustomMovementComponent::UCustomMovementComponent(const FObjectInitializer& Obj
 	StartSprintStaminaPct = 0.05f;  // 5% stamina to start sprinting
 	
 	NetworkStaminaCorrectionThreshold = 2.f;
+	NetworkStaminaBits = 8;
+	ScheduledModifierLeadMargin = 0.05f;
+	MaxScheduledModifierLead = 0.5f;
 
 	// Crouch
 	SetCrouchedHalfHeight(54.f);
 	
+	// Modifier channels, registered in the same order on every machine
+	HasteChannel = RegisterModifierChannel<FHasteLevel>({ TEXT("Haste"), &HasteLevels, &HasteLevelMethod, &bLimitMaxHastes, &MaxHastes,
+		[this](){ return CanHasteInCurrentState(); }, [this](){ return CustomMovementModifiers::CountLevels(HasteLevels, Haste); } });
+	SlowChannel = RegisterModifierChannel<FSlowLevel>({ TEXT("Slow"), &SlowLevels, &SlowLevelMethod, &bLimitMaxSlows, &MaxSlows,
+		[this](){ return CanSlowInCurrentState(); }, [this](){ return CustomMovementModifiers::CountLevels(SlowLevels, Slow); } });
+	SlowFallChannel = RegisterModifierChannel<FSlowFallLevel>({ TEXT("SlowFall"), &SlowFallLevels, &SlowFallLevelMethod, &bLimitMaxSlowFalls, &MaxSlowFalls,
+		[this](){ return CanSlowFallInCurrentState(); }, [this](){ return CustomMovementModifiers::CountLevels(SlowFallLevels, SlowFall); } });
+	
 	// Init Modifier Levels
 	if (Haste.Num()==0) { Haste.Add(CustomMovementGameplayTags::CustomMovement_Modifier_Haste, { 1.50f }); }		// 50% Speed Haste (Sprinting)
 	if (Slow.Num()==0) { Slow.Add(CustomMovementGameplayTags::CustomMovement_Modifier_Slowdown, { 0.50f });	}	 // 50% Speed Slow
 	if (SlowFall.Num()==0) { SlowFall.Add(CustomMovementGameplayTags::CustomMovement_Modifier_SlowFall, { 0.1f, EModifierFallZ::Enabled }); }  // 90% Gravity Reduction
 }
 
+namespace PredMovementNetSerialize
+{
+	/** Stamina is never sent with more bits, well within what a float dequantizes and requantizes exactly */
+	static constexpr int32 MaxStaminaBits = 16;
+
+	/** Bits of the client authority alpha sent with corrections */
+	static constexpr int32 ClientAuthAlphaBits = 8;
+
+	/** Rounds a value in [0, MaxValue] to the nearest of the 2^NumBits steps */
+	static uint32 Quantize(float Value, float MaxValue, int32 NumBits)
+	{
+		const uint32 MaxQuantized = (1u << NumBits) - 1;
+		return MaxValue > 0.f ? static_cast<uint32>(FMath::RoundToInt(FMath::Clamp(Value / MaxValue, 0.f, 1.f) * MaxQuantized)) : 0;
+	}
+
+	static float Dequantize(uint32 Quantized, float MaxValue, int32 NumBits)
+	{
+		const uint32 MaxQuantized = (1u << NumBits) - 1;
+		return MaxValue * Quantized / MaxQuantized;
+	}
+
+	/** Serializes a value in [0, MaxValue] in NumBits, rounded to the nearest step */
+	static void SerializeQuantized(FArchive& Ar, float& Value, float MaxValue, int32 NumBits)
+	{
+		uint32 Quantized = Ar.IsSaving() ? Quantize(Value, MaxValue, NumBits) : 0;
+		Ar.SerializeInt(Quantized, 1u << NumBits);
+		if (Ar.IsLoading())
+		{
+			Value = Dequantize(Quantized, MaxValue, NumBits);
+		}
+	}
+
+	/** Rounds stamina to a whole number of steps, negative stamina is sent as 0 */
+	static uint32 QuantizeStamina(float Value, float Step)
+	{
+		return static_cast<uint32>(FMath::RoundToInt(FMath::Clamp(Value / Step, 0.f, static_cast<float>(MAX_int32 / 2))));
+	}
+
+	/**
+	 * Serializes stamina as a whole number of steps in NumBits
+	 * The top value is an escape for stamina above the range, followed by the remaining steps packed, so values beyond the
+	 * class default range (e.g. MaxStamina raised at runtime) still arrive at the same precision instead of clamping
+	 * @param Step Stamina per step, 0 to send the raw value
+	 */
+	static void SerializeStamina(FArchive& Ar, float& Value, float Step, int32 NumBits)
+	{
+		if (Step <= 0.f)
+		{
+			Ar << Value;
+			return;
+		}
+
+		const uint32 Escape = (1u << NumBits) - 1;
+		uint32 Quantized = Ar.IsSaving() ? QuantizeStamina(Value, Step) : 0;
+		uint32 Code = FMath::Min(Quantized, Escape);
+		Ar.SerializeInt(Code, Escape + 1);
+		if (Code == Escape)
+		{
+			uint32 Excess = Quantized - Escape;
+			Ar.SerializeIntPacked(Excess);
+			Quantized = Escape + Excess;
+		}
+		else
+		{
+			Quantized = Code;
+		}
+
+		if (Ar.IsLoading())
+		{
+			Value = Quantized * Step;
+		}
+	}
+
+	/**
+	 * Serializes a field of a pending or old move as a single bit when it matches the new move of the same packet
+	 * @param NewMoveValue The field of the new move, already serialized, or null for the new move itself
+	 */
+	template<typename T, typename FSerializeValue>
+	static void SerializeSameAsNewMove(FArchive& Ar, T& Value, const T* NewMoveValue, FSerializeValue&& SerializeValue)
+	{
+		if (NewMoveValue)
+		{
+			uint8 bSame = Ar.IsSaving() && Value == *NewMoveValue;
+			Ar.SerializeBits(&bSame, 1);
+			if (bSame)
+			{
+				Value = *NewMoveValue;
+				return;
+			}
+		}
+		SerializeValue();
+	}
+}
+
 void FPredictedMoveResponseDataContainer::ServerFillResponseData(const UCharacterMovementComponent& CharacterMovement, const FClientAdjustment& PendingAdjustment)
 {
 	Super::ServerFillResponseData(CharacterMovement, PendingAdjustment);
@@ -124,9 +272,14 @@ void FPredictedMoveResponseDataContainer::ServerFillResponseData(const UCharacte
 	Stamina = MoveComp->GetStamina();
 
 	// Fill the response data with the current modifier state
-	HasteCorrection.ServerFillResponseData(MoveComp->HasteCorrection.Modifiers);
-	SlowCorrection.ServerFillResponseData(MoveComp->SlowCorrection.Modifiers);
-	SlowFallCorrection.ServerFillResponseData(MoveComp->SlowFallCorrection.Modifiers);
+	ForEachModifierWidth([&](auto& Response, const auto& Channels)
+	{
+		Response.ServerFillResponseData(Channels);
+		if (IsCorrection())
+		{
+			Response.ServerFillCorrectionData(Channels, PendingAdjustment.TimeStamp);
+		}
+	}, ModifierChannels, MoveComp->ModifierChannels);
 
 	// Fill ClientAuthAlpha
 	ClientAuthAlpha = MoveComp->ClientAuthAlpha;
@@ -141,22 +294,40 @@ bool FPredictedMoveResponseDataContainer::Serialize(UCharacterMovementComponent&
 	}
 
 	// Server ➜ Client
+
+	// Server initiated modifiers and modifier state acks ride on acks too, they only cost a bit once the client has them
+	// Nothing is sent for a level width without channels, both ends register the same channels
+	const UCustomMovementComponent& MoveComp = static_cast<const UCustomMovementComponent&>(CharacterMovement);
+	ForEachModifierWidth([&](auto& Response, const auto& Channels)
+	{
+		if (Channels.Num() > 0)
+		{
+			Response.SerializeNetStateAck(Ar);
+			Response.SerializeServerModifiers(Ar, Channels);
+			Response.SerializeSchedule(Ar, Channels);
+		}
+	}, ModifierChannels, MoveComp.ModifierChannels);
+
 	if (IsCorrection())
 	{
-		// Serialize Stamina
-		Ar << Stamina;
-		Ar << bStaminaDrained;
+		// Serialize Stamina, quantized well below NetworkStaminaCorrectionThreshold over the range both ends share
+		PredMovementNetSerialize::SerializeStamina(Ar, Stamina, MoveComp.GetNetworkStaminaStep(), MoveComp.GetNetworkStaminaBits());
+		Ar.SerializeBits(&bStaminaDrained, 1);
 
-		// Serialize Modifiers
-		Ar << HasteCorrection.Modifiers;
-		Ar << SlowCorrection.Modifiers;
-		Ar << SlowFallCorrection.Modifiers;
+		// Serialize Modifiers, only the channels that differ from the client's
+		ForEachModifierWidth([&](auto& Response, const auto& Channels)
+		{
+			if (Channels.Num() > 0)
+			{
+				Response.Serialize(Ar, Channels);
+			}
+		}, ModifierChannels, MoveComp.ModifierChannels);
 
 		// Serialize ClientAuthAlpha
 		Ar.SerializeBits(&bHasClientAuthAlpha, 1);
 		if (bHasClientAuthAlpha)
 		{
-			Ar << ClientAuthAlpha;
+			PredMovementNetSerialize::SerializeQuantized(Ar, ClientAuthAlpha, 1.f, PredMovementNetSerialize::ClientAuthAlphaBits);
 		}
 		else if (!Ar.IsSaving())
 		{
@@ -180,20 +351,22 @@ void FPredictedNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Chara
 	// ➜ MoveAutonomous (UpdateFromCompressedFlags)
 
 	const FPredictedSavedMove& SavedMove = static_cast<const FPredictedSavedMove&>(ClientMove);
+	UCustomMovementComponent* MoveComp = ClientMove.CharacterOwner ? Cast<UCustomMovementComponent>(ClientMove.CharacterOwner->GetCharacterMovement()) : nullptr;
 
 	// Compressed flags
 	CompressedMoveFlagsExtra = SavedMove.GetCompressedFlagsExtra();
 	
-	// Stamina
-	Stamina = SavedMove.EndStamina;
+	// Stamina, quantized here so the value sent is the one compared against the new move and by the server
+	Stamina = MoveComp ? MoveComp->QuantizeNetworkStamina(SavedMove.EndStamina) : SavedMove.EndStamina;
 	
-	// Fill the Modifier data from the saved move
-	HasteLocal.ClientFillNetworkMoveData(SavedMove.HasteLocal.WantsModifiers);
-	HasteCorrection.ClientFillNetworkMoveData(SavedMove.HasteCorrection.WantsModifiers, SavedMove.HasteCorrection.Modifiers);
-	SlowLocal.ClientFillNetworkMoveData(SavedMove.SlowLocal.WantsModifiers);
-	SlowCorrection.ClientFillNetworkMoveData(SavedMove.SlowCorrection.WantsModifiers, SavedMove.SlowCorrection.Modifiers);
-	SlowFallLocal.ClientFillNetworkMoveData(SavedMove.SlowFallLocal.WantsModifiers);
-	SlowFallCorrection.ClientFillNetworkMoveData(SavedMove.SlowFallCorrection.WantsModifiers, SavedMove.SlowFallCorrection.Modifiers);
+	// Fill the Modifier data from the saved move, labelled against the component's acknowledged state
+	if (MoveComp)
+	{
+		ForEachModifierWidth([](auto& MoveData, const auto& Saved, auto& Channels)
+		{
+			MoveData.ClientFillNetworkMoveData(Saved, Channels);
+		}, ModifierChannels, SavedMove.ModifierChannels, MoveComp->ModifierChannels);
+	}
 }
 
 bool FPredictedNetworkMoveData::Serialize(UCharacterMovementComponent& Movement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType)
@@ -202,71 +375,599 @@ bool FPredictedNetworkMoveData::Serialize(UCharacterMovementComponent& Movement,
 
 	// Client ➜ Server
 
+	// Pending and old moves follow the new move of the same packet and rarely differ from it, so each field costs a bit when it matches
+	const FPredictedNetworkMoveData* NewMoveData = MoveType != ENetworkMoveType::NewMove ?
+		static_cast<const FPredictedNetworkMoveData*>(Movement.GetNetworkMoveDataContainer().GetNewMoveData()) : nullptr;
+	using PredMovementNetSerialize::SerializeSameAsNewMove;
+	const UCustomMovementComponent& MoveComp = static_cast<const UCustomMovementComponent&>(Movement);
+
 	// Compressed flags
-	SerializeOptionalValue<uint8>(Ar.IsSaving(), Ar, CompressedMoveFlagsExtra, 0);
+	SerializeSameAsNewMove(Ar, CompressedMoveFlagsExtra, NewMoveData ? &NewMoveData->CompressedMoveFlagsExtra : nullptr, [&]()
+	{
+		SerializeOptionalValue<uint8>(Ar.IsSaving(), Ar, CompressedMoveFlagsExtra, 0);
+	});
 
 	// Stamina
-	SerializeOptionalValue<float>(Ar.IsSaving(), Ar, Stamina, 0.f);
+	SerializeSameAsNewMove(Ar, Stamina, NewMoveData ? &NewMoveData->Stamina : nullptr, [&]()
+	{
+		PredMovementNetSerialize::SerializeStamina(Ar, Stamina, MoveComp.GetNetworkStaminaStep(), MoveComp.GetNetworkStaminaBits());
+	});
 	
-	// Serialize Modifier data=
-	HasteLocal.Serialize(Ar, TEXT("HasteLocal"));
-	HasteCorrection.Serialize(Ar, TEXT("HasteCorrection"));
-	SlowLocal.Serialize(Ar, TEXT("SlowLocal"));
-	SlowCorrection.Serialize(Ar, TEXT("SlowCorrection"));
-	SlowFallLocal.Serialize(Ar, TEXT("SlowFallLocal"));
-	SlowFallCorrection.Serialize(Ar, TEXT("SlowFallCorrection"));
+	// Serialize Modifier data, nothing is sent for a level width without channels
+	SerializeSameAsNewMove(Ar, ModifierChannels, NewMoveData ? &NewMoveData->ModifierChannels : nullptr, [&]()
+	{
+		ForEachModifierWidth([&](auto& MoveData, const auto& Channels)
+		{
+			if (Channels.Num() > 0)
+			{
+				MoveData.Serialize(Ar, Channels);
+			}
+		}, ModifierChannels, MoveComp.ModifierChannels);
+	});
 
 	return !Ar.IsError();
 }
 
+bool UCustomMovementComponent::IsValidModifierChannel(FModifierChannelId Channel) const
+{
+	return Channel.IsValid() && ModifierChannels.Visit(Channel.Width, [&](const auto& Channels)
+	{
+		return Channel.Index < Channels.Num();
+	});
+}
+
+void UCustomMovementComponent::AddChannelModifier(FModifierChannelId Channel, int32 Level, bool bServerInitiated, float Duration)
+{
+	ModifierChannels.Visit(Channel.Width, [&](auto& Channels)
+	{
+		AddChannelModifier(Channels, Channel.Index, Level, bServerInitiated, Duration);
+	});
+}
+
+template<typename TLevel>
+void UCustomMovementComponent::AddChannelModifier(TModifierChannels<TLevel>& Channels, int32 Channel, int32 Level, bool bServerInitiated, float Duration)
+{
+	if (!ensureMsgf(Channels.IsValidLevel(Level), TEXT("%s modifier level %d does not fit the level width of the channel"), *Channels.Configs[Channel].Name, Level))
+	{
+		return;
+	}
+
+	bool bAdded = true;
+	if (!bServerInitiated)
+	{
+		bAdded = Channels.Correction[Channel].AddModifier(static_cast<TLevel>(Level));
+	}
+	else if (ensureMsgf(CharacterOwner && CharacterOwner->HasAuthority(), TEXT("Server initiated %s modifier can only be applied by the server"), *Channels.Configs[Channel].Name))
+	{
+		bAdded = Channels.AddServerModifier(Channel, static_cast<TLevel>(Level));
+	}
+	else
+	{
+		return;
+	}
+
+	// The stack holds CM_MAX_MODIFIER_STACK modifiers, the newest are kept, along with the timers of the modifiers left
+	if (!ensureMsgf(bAdded, TEXT("%s modifier stack is full, the oldest modifier was evicted. Increase CM_MAX_MODIFIER_STACK"), *Channels.Configs[Channel].Name))
+	{
+		Channels.TrimTimers(Channel, bServerInitiated);
+	}
+
+	if (Duration > 0.f)
+	{
+		// Expired by the movement simulation, the modifier stays applied if there is no timer left
+		ensureMsgf(Channels.Timers.Add(Channel, static_cast<TLevel>(Level), bServerInitiated, Duration),
+			TEXT("Too many timed modifiers, %s modifier will not expire. Increase CM_MAX_MODIFIER_TIMERS"), *Channels.Configs[Channel].Name);
+	}
+}
+
+void UCustomMovementComponent::RemoveChannelModifier(FModifierChannelId Channel, int32 Level, bool bServerInitiated)
+{
+	ModifierChannels.Visit(Channel.Width, [&](auto& Channels)
+	{
+		RemoveChannelModifier(Channels, Channel.Index, Level, bServerInitiated);
+	});
+}
+
+template<typename TLevel>
+void UCustomMovementComponent::RemoveChannelModifier(TModifierChannels<TLevel>& Channels, int32 Channel, int32 Level, bool bServerInitiated)
+{
+	if (!ensureMsgf(Channels.IsValidLevel(Level), TEXT("%s modifier level %d does not fit the level width of the channel"), *Channels.Configs[Channel].Name, Level))
+	{
+		return;
+	}
+
+	if (!bServerInitiated)
+	{
+		Channels.Correction[Channel].RemoveModifier(static_cast<TLevel>(Level), false);
+	}
+	else if (ensureMsgf(CharacterOwner && CharacterOwner->HasAuthority(), TEXT("Server initiated %s modifier can only be removed by the server"), *Channels.Configs[Channel].Name))
+	{
+		Channels.RemoveServerModifier(Channel, static_cast<TLevel>(Level), false);
+	}
+	else
+	{
+		return;
+	}
+
+	// A timer of the level left without a modifier would expire a modifier added later
+	Channels.TrimTimers(Channel, static_cast<TLevel>(Level), bServerInitiated);
+}
+
+int32 UCustomMovementComponent::GetChannelLevelIndex(FModifierChannelId Channel, const FGameplayTag& Tag) const
+{
+	// The built-in channels have a level index, none maps to INDEX_NONE
+	auto ToIndex = [](auto Level)
+	{
+		return Level != TModifierLevelTraits<decltype(Level)>::None ? static_cast<int32>(Level) : INDEX_NONE;
+	};
+	if (Channel == HasteChannel) { return ToIndex(GetHasteLevelIndex(Tag)); }
+	if (Channel == SlowChannel) { return ToIndex(GetSlowLevelIndex(Tag)); }
+	if (Channel == SlowFallChannel) { return ToIndex(GetSlowFallLevelIndex(Tag)); }
+
+	// Same as the level index, the first occurrence that fits the level width
+	return ModifierChannels.Visit(Channel.Width, [&](const auto& Channels)
+	{
+		return Channels.FindLevel(Channel.Index, Tag);
+	});
+}
+
+void UCustomMovementComponent::ResetChannelModifiers(FModifierChannelId Channel, bool bServerInitiated)
+{
+	ModifierChannels.Visit(Channel.Width, [&](auto& Channels)
+	{
+		ResetChannelModifiers(Channels, Channel.Index, bServerInitiated);
+	});
+}
+
+template<typename TLevel>
+void UCustomMovementComponent::ResetChannelModifiers(TModifierChannels<TLevel>& Channels, int32 Channel, bool bServerInitiated)
+{
+	if (!bServerInitiated)
+	{
+		Channels.Correction[Channel].ResetModifiers();
+	}
+	else if (ensureMsgf(CharacterOwner && CharacterOwner->HasAuthority(), TEXT("Server initiated %s modifier can only be cleared by the server"), *Channels.Configs[Channel].Name))
+	{
+		Channels.ResetServerModifiers(Channel);
+	}
+	else
+	{
+		return;
+	}
+
+	Channels.Timers.RemoveChannel(Channel, bServerInitiated);
+
+	// Scheduled modifiers are cleared on a scheduled move too, so the client clears them on the same move
+	if (bServerInitiated && Channels.HasScheduledModifiers(Channel))
+	{
+		ensureMsgf(Channels.AddScheduledModifier(Channel, EModifierOp::Reset, TModifierLevelTraits<TLevel>::None, GetScheduledModifierTimeStamp()),
+			TEXT("Too many scheduled modifiers, %s scheduled modifiers will not be cleared. Increase CM_MAX_SCHEDULED_MODIFIERS"), *Channels.Configs[Channel].Name);
+	}
+}
+
+void UCustomMovementComponent::ScheduleChannelModifier(FModifierChannelId Channel, int32 Level, float Duration)
+{
+	ModifierChannels.Visit(Channel.Width, [&](auto& Channels)
+	{
+		ScheduleChannelModifier(Channels, Channel.Index, Level, Duration);
+	});
+}
+
+template<typename TLevel>
+void UCustomMovementComponent::ScheduleChannelModifier(TModifierChannels<TLevel>& Channels, int32 Channel, int32 Level, float Duration)
+{
+	if (!ensureMsgf(CharacterOwner && CharacterOwner->HasAuthority(), TEXT("Scheduled %s modifier can only be applied by the server"), *Channels.Configs[Channel].Name))
+	{
+		return;
+	}
+
+	// Without a remote client there are no client moves to schedule on
+	if (CharacterOwner->IsLocallyControlled() || CharacterOwner->GetRemoteRole() != ROLE_AutonomousProxy)
+	{
+		AddChannelModifier(Channels, Channel, Level, true, Duration);
+		return;
+	}
+
+	// The removal is scheduled along with the modifier, so there must be room for both
+	const int32 NumEntries = Duration > 0.f ? 2 : 1;
+	if (!ensureMsgf(Channels.Schedule.Num() + NumEntries <= CM_MAX_SCHEDULED_MODIFIERS,
+		TEXT("Too many scheduled modifiers, %s modifier is applied as server initiated instead. Increase CM_MAX_SCHEDULED_MODIFIERS"), *Channels.Configs[Channel].Name))
+	{
+		AddChannelModifier(Channels, Channel, Level, true, Duration);
+		return;
+	}
+
+	if (!ensureMsgf(Channels.IsValidLevel(Level), TEXT("%s modifier level %d does not fit the level width of the channel"), *Channels.Configs[Channel].Name, Level))
+	{
+		return;
+	}
+
+	const float TimeStamp = GetScheduledModifierTimeStamp();
+	Channels.AddScheduledModifier(Channel, EModifierOp::Add, static_cast<TLevel>(Level), TimeStamp);
+	if (Duration > 0.f)
+	{
+		Channels.AddScheduledModifier(Channel, EModifierOp::Remove, static_cast<TLevel>(Level), TimeStamp + Duration);
+	}
+}
+
+float UCustomMovementComponent::GetScheduledModifierTimeStamp() const
+{
+	const FNetworkPredictionData_Server_Character* ServerData = GetPredictionData_Server_Character();
+	if (!ServerData)
+	{
+		return 0.f;
+	}
+
+	// The client is a round trip ahead of the last move received by the time the schedule reaches it
+	const APlayerState* PlayerState = CharacterOwner ? CharacterOwner->GetPlayerState() : nullptr;
+	const float RoundTripTime = PlayerState ? PlayerState->GetPingInMilliseconds() * 0.001f : 0.f;
+	const float Lead = FMath::Min(RoundTripTime + ScheduledModifierLeadMargin, MaxScheduledModifierLead);
+	return ServerData->CurrentClientTimeStamp + Lead;
+}
+
+float UCustomMovementComponent::GetSimulatedMoveTimeStamp() const
+{
+	// Without a remote client the moves have no client timestamps, and no other end to agree with
+	if (CharacterOwner && CharacterOwner->HasAuthority() && (CharacterOwner->IsLocallyControlled() || CharacterOwner->GetRemoteRole() != ROLE_AutonomousProxy))
+	{
+		return LocalMoveTimeStamp;
+	}
+
+	// New client moves are performed directly, the server and replays go through MoveAutonomous
+	if (CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_AutonomousProxy && !bClientUpdating)
+	{
+		if (const FNetworkPredictionData_Client_Character* ClientData = GetPredictionData_Client_Character())
+		{
+			return ClientData->CurrentTimeStamp;
+		}
+	}
+	return AutonomousMoveTimeStamp;
+}
+
 /*-- Haste --*/
-void UCustomMovementComponent::SetHasteByTag(const FGameplayTag Tag)
+void UCustomMovementComponent::SetHasteByTag(const FGameplayTag Tag, bool bServerInitiated, float Duration)
+{
+	EnsureModifierParams();
+
+	const FHasteLevel Level = GetHasteLevelIndex(Tag);
+	if (Level != TModifierLevelTraits<FHasteLevel>::None)
+	{
+		AddChannelModifier(HasteChannel, Level, bServerInitiated, Duration);
+	}
+}
+
+void UCustomMovementComponent::ScheduleHasteByTag(const FGameplayTag Tag, float Duration)
 {
-	const uint8 Level = GetHasteLevelIndex(Tag);
-	if (Level != NO_MODIFIER)
+	EnsureModifierParams();
+
+	const FHasteLevel Level = GetHasteLevelIndex(Tag);
+	if (Level != TModifierLevelTraits<FHasteLevel>::None)
 	{
-		HasteCorrection.AddModifier(Level);
+		ScheduleChannelModifier(HasteChannel, Level, Duration);
 	}
 }
 
-void UCustomMovementComponent::ClearHaste()
+void UCustomMovementComponent::ClearHaste(bool bServerInitiated)
 {
-	HasteCorrection.ResetModifiers();
+	ResetChannelModifiers(HasteChannel, bServerInitiated);
 }
 /*-- End Haste --*/
 
 /*-- Slow --*/
-void UCustomMovementComponent::SetSlowByTag(const FGameplayTag Tag)
+void UCustomMovementComponent::SetSlowByTag(const FGameplayTag Tag, bool bServerInitiated, float Duration)
+{
+	EnsureModifierParams();
+
+	const FSlowLevel Level = GetSlowLevelIndex(Tag);
+	if (Level != TModifierLevelTraits<FSlowLevel>::None)
+	{
+		AddChannelModifier(SlowChannel, Level, bServerInitiated, Duration);
+	}
+}
+
+void UCustomMovementComponent::ScheduleSlowByTag(const FGameplayTag Tag, float Duration)
 {
-	const uint8 Level = GetSlowLevelIndex(Tag);
-	if (Level != NO_MODIFIER)
+	EnsureModifierParams();
+
+	const FSlowLevel Level = GetSlowLevelIndex(Tag);
+	if (Level != TModifierLevelTraits<FSlowLevel>::None)
 	{
-		SlowCorrection.AddModifier(Level);
+		ScheduleChannelModifier(SlowChannel, Level, Duration);
 	}
 }
 
-void UCustomMovementComponent::ClearSlow()
+void UCustomMovementComponent::ClearSlow(bool bServerInitiated)
 {
-	SlowCorrection.ResetModifiers();
+	ResetChannelModifiers(SlowChannel, bServerInitiated);
 }
 /*-- End Slow --*/
 
 /*-- Slow falling --*/
-void UCustomMovementComponent::SetSlowFallByTag(const FGameplayTag Tag)
+void UCustomMovementComponent::SetSlowFallByTag(const FGameplayTag Tag, bool bServerInitiated, float Duration)
 {
-	const uint8 Level = GetSlowFallLevelIndex(Tag);
-	if (Level != NO_MODIFIER)
+	EnsureModifierParams();
+
+	const FSlowFallLevel Level = GetSlowFallLevelIndex(Tag);
+	if (Level != TModifierLevelTraits<FSlowFallLevel>::None)
+	{
+		AddChannelModifier(SlowFallChannel, Level, bServerInitiated, Duration);
+	}
+}
+
+void UCustomMovementComponent::ScheduleSlowFallByTag(const FGameplayTag Tag, float Duration)
+{
+	EnsureModifierParams();
+
+	const FSlowFallLevel Level = GetSlowFallLevelIndex(Tag);
+	if (Level != TModifierLevelTraits<FSlowFallLevel>::None)
 	{
-		SlowFallCorrection.AddModifier(Level);
+		ScheduleChannelModifier(SlowFallChannel, Level, Duration);
 	}
 }
 
-void UCustomMovementComponent::ClearSlowFalling()
+void UCustomMovementComponent::ClearSlowFalling(bool bServerInitiated)
 {
-	SlowFallCorrection.ResetModifiers();
+	ResetChannelModifiers(SlowFallChannel, bServerInitiated);
 }
 /*-- End Slow falling --*/
 
+/*-- Batch --*/
+void UCustomMovementComponent::SetHasteByTagBatch(const TArray<UCustomMovementComponent*>& Components, const FGameplayTag Tag, bool bServerInitiated, float Duration, bool bParallel)
+{
+	SetChannelModifierByTagBatch(Components, GetDefault<ThisClass>()->HasteChannel, Tag, bServerInitiated, Duration, bParallel);
+}
+
+void UCustomMovementComponent::SetSlowByTagBatch(const TArray<UCustomMovementComponent*>& Components, const FGameplayTag Tag, bool bServerInitiated, float Duration, bool bParallel)
+{
+	SetChannelModifierByTagBatch(Components, GetDefault<ThisClass>()->SlowChannel, Tag, bServerInitiated, Duration, bParallel);
+}
+
+void UCustomMovementComponent::SetSlowFallByTagBatch(const TArray<UCustomMovementComponent*>& Components, const FGameplayTag Tag, bool bServerInitiated, float Duration, bool bParallel)
+{
+	SetChannelModifierByTagBatch(Components, GetDefault<ThisClass>()->SlowFallChannel, Tag, bServerInitiated, Duration, bParallel);
+}
+
+void UCustomMovementComponent::SetChannelModifierByTagBatch(TConstArrayView<UCustomMovementComponent*> Components, FModifierChannelId Channel,
+	const FGameplayTag Tag, bool bServerInitiated, float Duration, bool bParallel)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UCustomMovementComponent::SetChannelModifierByTagBatch);
+
+	// Resolve on the game thread, the level tags may need rebuilding and derived classes may override the lookup
+	TArray<int32, TInlineAllocator<256>> Levels;
+	Levels.SetNumUninitialized(Components.Num());
+
+	// A component listed twice would be modified by two workers at once, each component is modified once
+	TSet<const UCustomMovementComponent*, DefaultKeyFuncs<const UCustomMovementComponent*>, TInlineSetAllocator<256>> Visited;
+	Visited.Reserve(Components.Num());
+
+	// Components of a class normally share their level tags, the level is resolved once and looked up again only where they differ
+	const UClass* SharedClass = nullptr;
+	const TArray<FGameplayTag>* SharedLevelTags = nullptr;
+	int32 SharedLevel = INDEX_NONE;
+
+	for (int32 Index = 0; Index < Components.Num(); ++Index)
+	{
+		UCustomMovementComponent* Component = Components[Index];
+		Levels[Index] = INDEX_NONE;
+		if (!IsValid(Component) || !Component->IsValidModifierChannel(Channel))
+		{
+			continue;
+		}
+
+		bool bAlreadyVisited = false;
+		Visited.Add(Component, &bAlreadyVisited);
+		if (bAlreadyVisited)
+		{
+			continue;
+		}
+
+		Component->EnsureModifierParams();
+		const TArray<FGameplayTag>* LevelTags = Component->ModifierChannels.Visit(Channel.Width, [&](const auto& Channels)
+		{
+			return Channels.Configs[Channel.Index].LevelTags;
+		});
+
+		if (SharedLevelTags && Component->GetClass() == SharedClass && *LevelTags == *SharedLevelTags)
+		{
+			Levels[Index] = SharedLevel;
+			continue;
+		}
+
+		Levels[Index] = Component->GetChannelLevelIndex(Channel, Tag);
+		if (!SharedLevelTags)
+		{
+			SharedClass = Component->GetClass();
+			SharedLevelTags = LevelTags;
+			SharedLevel = Levels[Index];
+		}
+	}
+
+	// Each component only touches its own modifier state
+	constexpr int32 MinParallelBatchSize = 64;
+	ParallelFor(TEXT("SetChannelModifierByTagBatch"), Components.Num(), MinParallelBatchSize, [&](int32 Index)
+	{
+		if (Levels[Index] != INDEX_NONE)
+		{
+			Components[Index]->AddChannelModifier(Channel, Levels[Index], bServerInitiated, Duration);
+		}
+	}, bParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+}
+
+void UCustomMovementComponent::GetComponentsFromOverlaps(TConstArrayView<FOverlapResult> Overlaps, TArray<UCustomMovementComponent*>& OutComponents)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UCustomMovementComponent::GetComponentsFromOverlaps);
+
+	// A character overlaps once per primitive, the batch needs each component once
+	TSet<UCustomMovementComponent*, DefaultKeyFuncs<UCustomMovementComponent*>, TInlineSetAllocator<64>> Seen;
+	OutComponents.Reserve(OutComponents.Num() + Overlaps.Num());
+	for (const FOverlapResult& Overlap : Overlaps)
+	{
+		const ACharacter* Character = Cast<ACharacter>(Overlap.GetActor());
+		UCustomMovementComponent* Component = Character ? Cast<UCustomMovementComponent>(Character->GetCharacterMovement()) : nullptr;
+		if (Component && !Seen.Contains(Component))
+		{
+			Seen.Add(Component);
+			OutComponents.Add(Component);
+		}
+	}
+}
+/*-- End Batch --*/
+
+/*-- Command Queue --*/
+void UCustomMovementComponent::QueueModifierCommand(FModifierChannelId Channel, EModifierOp Op, const FGameplayTag Tag, bool bServerInitiated, float Duration)
+{
+	// Channels are only registered from the constructor, so reading them from any thread is safe
+	if (!ensureMsgf(IsValidModifierChannel(Channel), TEXT("Queued modifier command for invalid channel %d"), Channel.Index))
+	{
+		return;
+	}
+
+	FModifierCommand Command;
+	Command.Tag = Tag;
+	Command.Duration = Duration;
+	Command.Channel = Channel;
+	Command.Op = Op;
+	Command.bServerInitiated = bServerInitiated;
+	ModifierCommands.Enqueue(MoveTemp(Command));
+}
+
+void UCustomMovementComponent::DrainModifierCommands()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UCustomMovementComponent::DrainModifierCommands);
+
+	if (ModifierCommands.IsEmpty())
+	{
+		return;
+	}
+
+	EnsureModifierParams();
+
+	FModifierCommand Command;
+	while (ModifierCommands.Dequeue(Command))
+	{
+		if (Command.Op == EModifierOp::Reset)
+		{
+			ResetChannelModifiers(Command.Channel, Command.bServerInitiated);
+			continue;
+		}
+
+		const int32 Level = GetChannelLevelIndex(Command.Channel, Command.Tag);
+		if (Level == INDEX_NONE)
+		{
+			continue;
+		}
+
+		if (Command.Op == EModifierOp::Add)
+		{
+			AddChannelModifier(Command.Channel, Level, Command.bServerInitiated, Command.Duration);
+		}
+		else
+		{
+			RemoveChannelModifier(Command.Channel, Level, Command.bServerInitiated);
+		}
+	}
+}
+/*-- End Command Queue --*/
+
+/*-- Tag Binding --*/
+FModifierChannelId UCustomMovementComponent::GetModifierChannelId(EModifierChannel Channel) const
+{
+	switch (Channel)
+	{
+	case EModifierChannel::Haste: return HasteChannel;
+	case EModifierChannel::Slow: return SlowChannel;
+	case EModifierChannel::SlowFall: return SlowFallChannel;
+	default: return {};
+	}
+}
+
+void UCustomMovementComponent::BindModifierTags(UAbilitySystemComponent* AbilitySystem)
+{
+	UnbindModifierTags();
+
+	if (!AbilitySystem || !CharacterOwner)
+	{
+		return;
+	}
+
+	BoundAbilitySystem = AbilitySystem;
+	ModifierTagBindingHandles.SetNum(ModifierTagBindings.Num());
+	ActiveModifierTagBindings.Init(false, ModifierTagBindings.Num());
+
+	for (int32 Index = 0; Index < ModifierTagBindings.Num(); ++Index)
+	{
+		const FModifierTagBinding& Binding = ModifierTagBindings[Index];
+		if (!Binding.OwnedTag.IsValid() || !GetModifierChannelId(Binding.Channel).IsValid())
+		{
+			continue;
+		}
+
+		// Server only tags are pushed to the client by the server
+		if (Binding.bServerInitiated && !CharacterOwner->HasAuthority())
+		{
+			continue;
+		}
+
+		ModifierTagBindingHandles[Index] = AbilitySystem->RegisterGameplayTagEvent(Binding.OwnedTag, EGameplayTagEventType::NewOrRemoved)
+			.AddUObject(this, &ThisClass::OnModifierBindingTagChanged, Index);
+
+		// The event only fires on change, apply the tags it already has
+		OnModifierBindingTagChanged(Binding.OwnedTag, AbilitySystem->GetTagCount(Binding.OwnedTag), Index);
+	}
+}
+
+void UCustomMovementComponent::UnbindModifierTags()
+{
+	// Unbinding is on the game thread, so the modifiers are removed now rather than queued, e.g. at EndPlay there is no next move
+	// Queued changes go first, so an add the bindings queued earlier can't land after its removal
+	DrainModifierCommands();
+	EnsureModifierParams();
+
+	UAbilitySystemComponent* AbilitySystem = BoundAbilitySystem.Get();
+	for (int32 Index = 0; Index < ModifierTagBindingHandles.Num(); ++Index)
+	{
+		if (ModifierTagBindingHandles[Index].IsValid() && ModifierTagBindings.IsValidIndex(Index))
+		{
+			const FModifierTagBinding& Binding = ModifierTagBindings[Index];
+			if (AbilitySystem)
+			{
+				AbilitySystem->RegisterGameplayTagEvent(Binding.OwnedTag, EGameplayTagEventType::NewOrRemoved).Remove(ModifierTagBindingHandles[Index]);
+			}
+
+			// The modifiers belonged to the tags of that ability system
+			if (ActiveModifierTagBindings.IsValidIndex(Index) && ActiveModifierTagBindings[Index])
+			{
+				ActiveModifierTagBindings[Index] = false;
+				const FModifierChannelId Channel = GetModifierChannelId(Binding.Channel);
+				const int32 Level = GetChannelLevelIndex(Channel, Binding.Level);
+				if (Level != INDEX_NONE)
+				{
+					RemoveChannelModifier(Channel, Level, Binding.bServerInitiated);
+				}
+			}
+		}
+	}
+
+	BoundAbilitySystem.Reset();
+	ModifierTagBindingHandles.Reset();
+	ActiveModifierTagBindings.Empty();
+}
+
+void UCustomMovementComponent::OnModifierBindingTagChanged(const FGameplayTag Tag, int32 NewCount, int32 BindingIndex)
+{
+	const bool bActive = NewCount > 0;
+	if (!ActiveModifierTagBindings.IsValidIndex(BindingIndex) || ActiveModifierTagBindings[BindingIndex] == bActive)
+	{
+		return;
+	}
+	ActiveModifierTagBindings[BindingIndex] = bActive;
+
+	// Applied at the start of the next move, like any other queued change
+	const FModifierTagBinding& Binding = ModifierTagBindings[BindingIndex];
+	QueueModifierCommand(GetModifierChannelId(Binding.Channel), bActive ? EModifierOp::Add : EModifierOp::Remove, Binding.Level, Binding.bServerInitiated);
+}
+/*-- End Tag Binding --*/
+
 
 void UCustomMovementComponent::StartSprint()
 {
@@ -304,9 +1005,46 @@ void UCustomMovementComponent::PostEditChangeProperty(struct FPropertyChangedEve
 		// Update max stamina
 		SetMaxStamina(BaseMaxStamina);
 	}
+	else if (PropertyThatChanged && PropertyThatChanged->GetFName() == GET_MEMBER_NAME_CHECKED(ThisClass, Haste))
+	{
+		// Levels follow the map order again, there are no live modifiers to keep their index for
+		HasteLevels.Reset();
+		RebuildModifierParams();
+	}
+	else if (PropertyThatChanged && PropertyThatChanged->GetFName() == GET_MEMBER_NAME_CHECKED(ThisClass, Slow))
+	{
+		SlowLevels.Reset();
+		RebuildModifierParams();
+	}
+	else if (PropertyThatChanged && PropertyThatChanged->GetFName() == GET_MEMBER_NAME_CHECKED(ThisClass, SlowFall))
+	{
+		SlowFallLevels.Reset();
+		RebuildModifierParams();
+	}
 }
 #endif
 
+void UCustomMovementComponent::PostLoad()
+{
+	Super::PostLoad();
+
+	RebuildModifierParams();
+}
+
+void UCustomMovementComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	// Gameplay may set modifiers by tag before the first movement tick
+	RebuildModifierParams();
+
+	// The wire format of the modifier stacks comes from the archetype, which client and server load alike, so runtime edits on
+	// one end can't desync the bitstream. Only read, the archetype may be the class default object
+	const UCustomMovementComponent* Archetype = CastChecked<UCustomMovementComponent>(GetArchetype());
+	ForEachModifierWidth([](auto& Channels, const auto& ArchetypeChannels) { Channels.InitNetFormats(ArchetypeChannels); },
+		ModifierChannels, Archetype->ModifierChannels);
+}
+
 void UCustomMovementComponent::BeginPlay()
 {
 	Super::BeginPlay();
@@ -316,6 +1054,25 @@ void UCustomMovementComponent::BeginPlay()
 
 	// Set stamina to max
 	SetStamina(GetMaxStamina());
+
+	// Drive modifiers from the owner's tags, if it has an ability system yet
+	if (ModifierTagBindings.Num() > 0)
+	{
+		if (UAbilitySystemComponent* AbilitySystem = UAbilitySystemBlueprintLibrary::GetAbilitySystemComponent(GetOwner()))
+		{
+			BindModifierTags(AbilitySystem);
+		}
+	}
+}
+
+void UCustomMovementComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnbindModifierTags();
+
+	// Nothing drains the queue once play ended, drop whatever other threads queued meanwhile
+	ModifierCommands.Empty();
+
+	Super::EndPlay(EndPlayReason);
 }
 
 ECustomMovementGaitMode UCustomMovementComponent::GetGaitMode() const
@@ -356,7 +1113,9 @@ bool UCustomMovementComponent::IsGaitAtSpeed(float Mitigator) const
 
 	// When struggling to surpass walk speed, which can occur with heavy rotation and low acceleration, we
 	// mitigate the check so there isn't a constant re-entry that can occur as an edge case
-	return Vel >= FMath::Square(GetBaseMaxSpeed() * GetGaitSpeedFactor()) * Mitigator;
+	const FResolvedMovementAttributes* Attributes = GetResolvedMovementAttributes();
+	const float GaitSpeed = Attributes ? Attributes->BaseMaxSpeed * Attributes->GaitSpeedFactor : GetBaseMaxSpeed() * GetGaitSpeedFactor();
+	return Vel >= FMath::Square(GaitSpeed) * Mitigator;
 }
 
 bool UCustomMovementComponent::IsWalk() const
@@ -523,8 +1282,54 @@ float UCustomMovementComponent::GetBaseBrakingFriction() const
 	return BrakingFriction;
 }
 
+float UCustomMovementComponent::GetMaxAcceleration() const
+{
+	// Base acceleration depends on sprinting in effect, which depends on velocity, so only the scalar is resolved
+	const FResolvedMovementAttributes* Attributes = GetResolvedMovementAttributes();
+	return GetBaseMaxAcceleration() * (Attributes ? Attributes->MaxAccelerationScalar : GetMaxAccelerationScalar());
+}
+
+float UCustomMovementComponent::GetMaxSpeed() const
+{
+	if (const FResolvedMovementAttributes* Attributes = GetResolvedMovementAttributes())
+	{
+		return Attributes->BaseMaxSpeed * Attributes->MaxSpeedScalar;
+	}
+	return GetBaseMaxSpeed() * GetMaxSpeedScalar();
+}
+
+float UCustomMovementComponent::GetMaxBrakingDeceleration() const
+{
+	if (const FResolvedMovementAttributes* Attributes = GetResolvedMovementAttributes())
+	{
+		return Attributes->BaseMaxBrakingDeceleration * Attributes->MaxBrakingDecelerationScalar;
+	}
+	return GetBaseMaxBrakingDeceleration() * GetMaxBrakingDecelerationScalar();
+}
+
+float UCustomMovementComponent::GetGroundFriction(float DefaultGroundFriction) const
+{
+	// Base ground friction depends on the caller's default friction, so only the scalar is resolved
+	const FResolvedMovementAttributes* Attributes = GetResolvedMovementAttributes();
+	return GetBaseGroundFriction(DefaultGroundFriction) * (Attributes ? Attributes->GroundFrictionScalar : GetGroundFrictionScalar());
+}
+
+float UCustomMovementComponent::GetBrakingFriction() const
+{
+	if (const FResolvedMovementAttributes* Attributes = GetResolvedMovementAttributes())
+	{
+		return Attributes->BaseBrakingFriction * Attributes->BrakingFrictionScalar;
+	}
+	return GetBaseBrakingFriction() * GetBrakingFrictionScalar();
+}
+
 float UCustomMovementComponent::GetGravityZ() const
 {
+	const FResolvedMovementAttributes* Attributes = GetResolvedMovementAttributes();
+	if (Attributes && !Attributes->bGravityZScalarFromVelocity)
+	{
+		return Super::GetGravityZ() * Attributes->GravityZScalar;
+	}
 	return Super::GetGravityZ() * GetGravityZScalar();
 }
 
@@ -539,6 +1344,78 @@ FVector UCustomMovementComponent::GetAirControl(float DeltaTime, float TickAirCo
 	return Super::GetAirControl(DeltaTime, TickAirControl, FallAcceleration);
 }
 
+void UCustomMovementComponent::ResolveMovementAttributes()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UCustomMovementComponent::ResolveMovementAttributes);
+
+	// Resolve everything live, the previous attributes must not feed into the new ones
+	ResolvedAttributes.bValid = false;
+
+	if (!HasValidData())
+	{
+		return;
+	}
+
+	FResolvedMovementAttributes& Attributes = ResolvedAttributes;
+
+	// State the attributes are resolved from
+	Attributes.MovementMode = MovementMode;
+	Attributes.CustomMovementMode = CustomMovementMode;
+	Attributes.bCrouched = CharacterOwner->bIsCrouched;
+	Attributes.bSprinting = bIsSprinting;
+	Attributes.bWalking = bIsWalking;
+	Attributes.bStaminaDrained = bStaminaDrained;
+	ForEachModifierWidth([](auto& Levels, const auto& Channels) { Levels = Channels.Levels; }, Attributes.ModifierLevels, ModifierChannels);
+
+	// Resolved attributes
+	Attributes.GaitMode = GetGaitMode();
+	Attributes.GaitSpeedFactor = GetGaitSpeedFactor();
+	Attributes.BaseMaxSpeed = GetBaseMaxSpeed();
+	Attributes.BaseMaxBrakingDeceleration = GetBaseMaxBrakingDeceleration();
+	Attributes.BaseBrakingFriction = GetBaseBrakingFriction();
+	Attributes.MaxAccelerationScalar = GetMaxAccelerationScalar();
+	Attributes.MaxSpeedScalar = GetMaxSpeedScalar();
+	Attributes.MaxBrakingDecelerationScalar = GetMaxBrakingDecelerationScalar();
+	Attributes.GroundFrictionScalar = GetGroundFrictionScalar();
+	Attributes.BrakingFrictionScalar = GetBrakingFrictionScalar();
+	Attributes.RootMotionTranslationScalar = GetRootMotionTranslationScalar();
+
+	// Gravity sampled from a fall velocity curve changes throughout the move
+	const FFallingModifierParams* SlowFallParams = GetSlowFallParams();
+	Attributes.bGravityZScalarFromVelocity = SlowFallParams && SlowFallParams->bGravityScalarFromVelocityZ;
+	Attributes.GravityZScalar = Attributes.bGravityZScalarFromVelocity ? 1.f : GetGravityZScalar();
+
+	Attributes.bValid = true;
+}
+
+const FResolvedMovementAttributes* UCustomMovementComponent::GetResolvedMovementAttributes() const
+{
+	const FResolvedMovementAttributes& Attributes = ResolvedAttributes;
+	if (!Attributes.bValid || !CharacterOwner)
+	{
+		return nullptr;
+	}
+
+	// Anything that changed mid-move (sprint, crouch, landing, stamina drain, etc.) falls back to resolving live
+	const bool bMatchesState =
+		Attributes.MovementMode == MovementMode &&
+		Attributes.CustomMovementMode == CustomMovementMode &&
+		Attributes.bCrouched == CharacterOwner->bIsCrouched &&
+		Attributes.bSprinting == bIsSprinting &&
+		Attributes.bWalking == bIsWalking &&
+		Attributes.bStaminaDrained == bStaminaDrained &&
+		AllModifierWidths([](const auto& Levels, const auto& Channels) { return Levels == Channels.Levels; }, Attributes.ModifierLevels, ModifierChannels);
+
+	return bMatchesState ? &Attributes : nullptr;
+}
+
+void UCustomMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
+{
+	InvalidateMovementAttributes();
+
+	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+}
+
 void UCustomMovementComponent::CalcStamina(float DeltaTime)
 {
 	// Do not update velocity when using root motion or when SimulatedProxy and not simulating root motion - SimulatedProxy are repped their Velocity
@@ -783,6 +1660,41 @@ void UCustomMovementComponent::SetMaxStamina(float NewMaxStamina)
 	}
 }
 
+int32 UCustomMovementComponent::GetNetworkStaminaBits() const
+{
+	using PredMovementNetSerialize::MaxStaminaBits;
+
+	// Shared config only, the live MaxStamina isn't replicated and may differ between client and server
+	// The archetype carries the Blueprint's and the owning actor's overrides, both ends spawn from it
+	const UCustomMovementComponent* Defaults = CastChecked<UCustomMovementComponent>(GetArchetype());
+	const float Range = Defaults->BaseMaxStamina;
+	const float Threshold = Defaults->NetworkStaminaCorrectionThreshold;
+
+	// The range spans all but the escape value, and a step of Range / (2^Bits - 2) must not exceed half of the threshold
+	const float MaxSteps = Threshold > 0.f ? 2.f * Range / Threshold : TNumericLimits<float>::Max();
+	const int32 ThresholdBits = MaxSteps < static_cast<float>(1 << MaxStaminaBits) ? FMath::CeilLogTwo(static_cast<uint32>(FMath::CeilToInt(MaxSteps)) + 2) : MaxStaminaBits;
+	return FMath::Clamp(FMath::Max(Defaults->NetworkStaminaBits, ThresholdBits), 2, MaxStaminaBits);
+}
+
+float UCustomMovementComponent::GetNetworkStaminaStep() const
+{
+	const UCustomMovementComponent* Defaults = CastChecked<UCustomMovementComponent>(GetArchetype());
+	if (Defaults->BaseMaxStamina > 0.f)
+	{
+		// BaseMaxStamina lands on the last value below the escape
+		return Defaults->BaseMaxStamina / static_cast<float>((1 << GetNetworkStaminaBits()) - 2);
+	}
+
+	// No range to scale to, fall back to an absolute step within the threshold
+	return FMath::Max(Defaults->NetworkStaminaCorrectionThreshold, 0.f) * 0.5f;
+}
+
+float UCustomMovementComponent::QuantizeNetworkStamina(float Value) const
+{
+	const float Step = GetNetworkStaminaStep();
+	return Step > 0.f ? PredMovementNetSerialize::QuantizeStamina(Value, Step) * Step : Value;
+}
+
 void UCustomMovementComponent::SetStaminaDrained(bool bNewValue)
 {
 	const bool bWasStaminaDrained = bStaminaDrained;
@@ -902,31 +1814,31 @@ bool UCustomMovementComponent::RemoveVelocityZOnSlowFallStart() const
 	return false;
 }
 
+void UCustomMovementComponent::RebuildModifierParams()
+{
+	// Index the modifier levels, so setting modifiers by tag is a hash lookup
+	CustomMovementModifiers::RebuildLevels(HasteLevels, HasteLevelIndex, Haste);
+	CustomMovementModifiers::RebuildLevels(SlowLevels, SlowLevelIndex, Slow);
+	CustomMovementModifiers::RebuildLevels(SlowFallLevels, SlowFallLevelIndex, SlowFall);
+
+	// Resolve the params of each level up front, so the getters are an array index
+	HasteParamsTable.Rebuild(HasteLevels, Haste);
+	SlowParamsTable.Rebuild(SlowLevels, Slow);
+	SlowFallParamsTable.Rebuild(SlowFallLevels, SlowFall);
+
+	BuiltModifierParamsVersion = ModifierParamsVersion;
+
+	// The resolved scalars came from the old params
+	InvalidateMovementAttributes();
+}
+
 void UCustomMovementComponent::ProcessModifierMovementState()
 {
 	// Proxies get replicated Modifier state.
+	// Every registered channel is processed in a single pass over the channel arrays, without allocating
 	if (CharacterOwner->GetLocalRole() != ROLE_SimulatedProxy)
 	{
-		// Haste
-		{
-			TArray<FMovementModifier*> HasteMods = { &HasteCorrection };
-			FModifierStatics::ProcessModifiers(HasteLevel, HasteLevelMethod, HasteLevels, bLimitMaxHastes, MaxHastes, NO_MODIFIER, HasteMods,
-				[this](){ return CanHasteInCurrentState(); });
-		}
-
-		// Slow
-		{
-			TArray<FMovementModifier*> SlowMods = { &SlowCorrection };
-			FModifierStatics::ProcessModifiers(SlowLevel, SlowLevelMethod, SlowLevels, bLimitMaxSlows, MaxSlows, NO_MODIFIER, SlowMods,
-				[this](){ return CanSlowInCurrentState(); });
-		}
-
-		// SlowFall
-		{
-			TArray<FMovementModifier*> SlowFallMods = { &SlowFallCorrection };
-			FModifierStatics::ProcessModifiers(SlowFallLevel, SlowFallLevelMethod, SlowFallLevels, bLimitMaxSlowFalls, MaxSlowFalls, NO_MODIFIER, SlowFallMods,
-				[this](){ return CanSlowFallInCurrentState(); });
-		}
+		ForEachModifierWidth([](auto& Channels) { Channels.Process(); }, ModifierChannels);
 	}
 }
 
@@ -937,15 +1849,22 @@ void UCustomMovementComponent::UpdateModifierMovementState()
 		return;
 	}
 	
-	// Initialize Modifier levels if empty
-	if (HasteLevels.Num() == 0)	{ for (const auto& Level : Haste) { HasteLevels.Add(Level.Key); } }
-	if (SlowLevels.Num() == 0)	{ for (const auto& Level : Slow) { SlowLevels.Add(Level.Key); } }
-	if (SlowFallLevels.Num() == 0) { for (const auto& Level : SlowFall) { SlowFallLevels.Add(Level.Key); } }
+	// Only rebuilds if the modifier maps changed since the last rebuild
+	EnsureModifierParams();
 
 	// Update the modifiers
 	ProcessModifierMovementState();
 }
 
+void UCustomMovementComponent::ControlledCharacterMove(const FVector& InputVector, float DeltaSeconds)
+{
+	// Apply modifier changes queued from other threads before the move is saved, so the saved move sends the modifiers it simulates
+	// Replays don't come through here, the wanted modifiers are restored once the replay is done and would discard them
+	DrainModifierCommands();
+
+	Super::ControlledCharacterMove(InputVector, DeltaSeconds);
+}
+
 void UCustomMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
 {
 	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
@@ -958,6 +1877,24 @@ void UCustomMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSec
 	// Detect when slow fall starts
 	const bool bWasSlowFalling = IsSlowFallActive();
 
+	// Expire timed modifiers on the move timestamps, so client and server expire them on the same move
+	// Replayed moves advance from the timers their saved move restored in PrepMoveFor
+	if (CharacterOwner->GetLocalRole() != ROLE_SimulatedProxy)
+	{
+		LocalMoveTimeStamp = LocalMoveTimeStamp > MinTimeBetweenTimeStampResets ? DeltaSeconds : LocalMoveTimeStamp + DeltaSeconds;
+		const float MoveTimeStamp = GetSimulatedMoveTimeStamp();
+		ForEachModifierWidth([&](auto& Channels)
+		{
+			Channels.AdvanceTimers(MoveTimeStamp, MinTimeBetweenTimeStampResets);
+
+			// Apply the scheduled modifiers reached by this move, the server keeps them until the client acknowledges them
+			if (!Channels.Schedule.IsEmpty())
+			{
+				Channels.ApplySchedule(MoveTimeStamp, MinTimeBetweenTimeStampResets, CharacterOwner->HasAuthority());
+			}
+		}, ModifierChannels);
+	}
+
 	// Update movement modifiers
 	UpdateModifierMovementState();
 	
@@ -1005,6 +1942,9 @@ void UCustomMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSec
 			Crouch(false);
 		}
 	}
+
+	// Resolve the movement attributes once for the move, now that gait, stance and modifiers are settled
+	ResolveMovementAttributes();
 }
 
 void UCustomMovementComponent::UpdateCharacterStateAfterMovement(float DeltaSeconds)
@@ -1021,6 +1961,9 @@ void UCustomMovementComponent::UpdateCharacterStateAfterMovement(float DeltaSeco
 	}
 
 	Super::UpdateCharacterStateAfterMovement(DeltaSeconds);
+
+	// Queries between moves (animation, abilities, etc.) resolve live
+	InvalidateMovementAttributes();
 	
 #if UE_ENABLE_DEBUG_DRAWING
 	// Draw Stamina values to Screen
@@ -1051,9 +1994,11 @@ void UCustomMovementComponent::ServerMove_PerformMovement(const FCharacterNetwor
 	
 	const FPredictedNetworkMoveData& PredMoveData = static_cast<const FPredictedNetworkMoveData&>(MoveData);
 
-	HasteCorrection.ServerMove_PerformMovement(PredMoveData.HasteCorrection.WantsModifiers);
-	SlowCorrection.ServerMove_PerformMovement(PredMoveData.SlowCorrection.WantsModifiers);
-	SlowFallCorrection.ServerMove_PerformMovement(PredMoveData.SlowFallCorrection.WantsModifiers);
+	// Queued modifier changes apply at the start of a client move, like ControlledCharacterMove does for local moves
+	DrainModifierCommands();
+
+	ForEachModifierWidth([](auto& Channels, const auto& MoveData) { Channels.ServerMove_PerformMovement(MoveData); },
+		ModifierChannels, PredMoveData.ModifierChannels);
 
 	Super::ServerMove_PerformMovement(MoveData);
 }
@@ -1235,15 +2180,15 @@ bool UCustomMovementComponent::ServerCheckClientError(float ClientTimeStamp, flo
 	 * This will trigger a client correction if the Stamina value in the Client differs
 	 * NetworkStaminaCorrectionThreshold (2.f default) units from the one in the server
 	 * De-syncs can happen if we set the Stamina directly in Gameplay code (ie: GAS)
+	 * The client's value arrives quantized, so the server's is quantized the same way before comparing
 	 */
-	if (!FMath::IsNearlyEqual(CurrentMoveData->Stamina, Stamina, NetworkStaminaCorrectionThreshold))
+	if (!FMath::IsNearlyEqual(CurrentMoveData->Stamina, QuantizeNetworkStamina(Stamina), NetworkStaminaCorrectionThreshold))
 	{
 		return true;
 	}
 
-	if (HasteCorrection.ServerCheckClientError(CurrentMoveData->HasteCorrection.Modifiers))	{ return true; }
-	if (SlowCorrection.ServerCheckClientError(CurrentMoveData->SlowCorrection.Modifiers))	{ return true; }
-	if (SlowFallCorrection.ServerCheckClientError(CurrentMoveData->SlowFallCorrection.Modifiers)) { return true; }
+	if (AnyModifierWidth([](const auto& Channels, const auto& MoveData) { return Channels.ServerCheckClientError(MoveData); },
+		ModifierChannels, CurrentMoveData->ModifierChannels)) { return true; }
 	
 	return false;
 }
@@ -1278,6 +2223,13 @@ void UCustomMovementComponent::ServerMoveHandleClientError(float ClientTimeStamp
 		ClientAuthAlpha = AuthData ? AuthData->Alpha : 0.f;
 	}
 
+	// Corrections only resend the modifiers that differ from the ones the client reported with this move
+	if (const FPredictedNetworkMoveData* MoveData = static_cast<const FPredictedNetworkMoveData*>(GetCurrentNetworkMoveData()))
+	{
+		ForEachModifierWidth([&](auto& Channels, const auto& ClientChannels) { Channels.ServerCacheClientModifiers(ClientChannels, ClientTimeStamp); },
+			ModifierChannels, MoveData->ModifierChannels);
+	}
+
 	// The move prepared here will finally be sent in the next ReplicateMoveToServer()
 
 	Super::ServerMoveHandleClientError(ClientTimeStamp, DeltaTime, Accel, RelativeClientLocation, ClientMovementBase,
@@ -1305,6 +2257,20 @@ void UCustomMovementComponent::ClientAdjustPosition_Implementation(float TimeSta
 	UpdatedComponent->SetWorldLocation(AuthLocation, false);
 }
 
+void UCustomMovementComponent::ClientHandleMoveResponse(const FCharacterMoveResponseDataContainer& MoveResponse)
+{
+	// Server >> ClientMoveResponsePacked() ➜ ClientHandleMoveResponse() ➜ ClientAckGoodMove() or ClientAdjustPosition()
+	
+	if (HasValidData())
+	{
+		const FPredictedMoveResponseDataContainer& PredMoveResponse = static_cast<const FPredictedMoveResponseDataContainer&>(MoveResponse);
+		ForEachModifierWidth([](auto& Channels, const auto& Response) { Channels.OnServerModifiersReceived(Response); },
+			ModifierChannels, PredMoveResponse.ModifierChannels);
+	}
+
+	Super::ClientHandleMoveResponse(MoveResponse);
+}
+
 void UCustomMovementComponent::OnClientCorrectionReceived(class FNetworkPredictionData_Client_Character& ClientData,
                                                           float TimeStamp, FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName,
                                                           bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode, FVector ServerGravityDirection)
@@ -1321,10 +2287,13 @@ void UCustomMovementComponent::OnClientCorrectionReceived(class FNetworkPredicti
 	SetStamina(MoveResponse.Stamina);
 	SetStaminaDrained(MoveResponse.bStaminaDrained);
 
-	// Modifiers
-	HasteCorrection.OnClientCorrectionReceived(MoveResponse.HasteCorrection.Modifiers);
-	SlowCorrection.OnClientCorrectionReceived(MoveResponse.SlowCorrection.Modifiers);
-	SlowFallCorrection.OnClientCorrectionReceived(MoveResponse.SlowFallCorrection.Modifiers);
+	// Modifiers, the corrected move was just acknowledged and holds the ones the server didn't resend
+	const FPredictedSavedMove* CorrectedMove = ClientData.LastAckedMove.IsValid() && ClientData.LastAckedMove->TimeStamp == TimeStamp ?
+		static_cast<const FPredictedSavedMove*>(ClientData.LastAckedMove.Get()) : nullptr;
+	ModifierChannels.Narrow.OnClientCorrectionReceived(MoveResponse.ModifierChannels.Narrow, CorrectedMove ? &CorrectedMove->ModifierChannels.Narrow : nullptr);
+	ModifierChannels.Wide.OnClientCorrectionReceived(MoveResponse.ModifierChannels.Wide, CorrectedMove ? &CorrectedMove->ModifierChannels.Wide : nullptr);
+
+	NumClientCorrections++;
 	
 	Super::OnClientCorrectionReceived(ClientData, TimeStamp, NewLocation, NewVelocity, NewBase, NewBaseBoneName,
 		bHasBase, bBaseRelativePosition, ServerMovementMode, ServerGravityDirection);
@@ -1342,6 +2311,8 @@ void UCustomMovementComponent::MoveAutonomous(float ClientTimeStamp, float Delta
 		// Extra set of compression flags
 		UpdateFromCompressedFlagsExtra(MoveData->CompressedMoveFlagsExtra);
 	}
+
+	AutonomousMoveTimeStamp = ClientTimeStamp;
 	
 	Super::MoveAutonomous(ClientTimeStamp, DeltaTime, CompressedFlags, NewAccel);
 }
@@ -1381,16 +2352,7 @@ void FPredictedSavedMove::Clear()
 	EndStamina = 0.f;
 	
 	// Modifiers
-	HasteLocal.Clear();
-	HasteCorrection.Clear();
-	SlowLocal.Clear();
-	SlowCorrection.Clear();
-	SlowFallLocal.Clear();
-	SlowFallCorrection.Clear();
-	
-	HasteLevel = NO_MODIFIER;
-	SlowLevel = NO_MODIFIER;
-	SlowFallLevel = NO_MODIFIER;
+	ForEachModifierWidth([](auto& Channels) { Channels.Clear(); }, ModifierChannels);
 }
 
 bool FPredictedSavedMove::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter,	float MaxDelta) const
@@ -1419,17 +2381,9 @@ bool FPredictedSavedMove::CanCombineWith(const FSavedMovePtr& NewMove, ACharacte
 	// We can only combine moves if they will result in the same state as if both moves were processed individually,
 	// because the AutonomousProxy Client processes them individually prior to sending them to the server.
 	
-	if (!HasteLocal.CanCombineWith(SavedMove->HasteLocal.WantsModifiers)) { return false; }
-	if (!HasteCorrection.CanCombineWith(SavedMove->HasteCorrection.WantsModifiers)) { return false; }
-	if (!SlowLocal.CanCombineWith(SavedMove->SlowLocal.WantsModifiers)) { return false; }
-	if (!SlowCorrection.CanCombineWith(SavedMove->SlowCorrection.WantsModifiers)) { return false; }
-	if (!SlowFallLocal.CanCombineWith(SavedMove->SlowFallLocal.WantsModifiers)) { return false; }
-	if (!SlowFallCorrection.CanCombineWith(SavedMove->SlowFallCorrection.WantsModifiers)) { return false; }
-
-	// Without these, the change/start/stop events will trigger twice causing de-sync, so we don't combine moves if the level changes
-	if (HasteLevel != SavedMove->HasteLevel) { return false; }
-	if (SlowLevel != SavedMove->SlowLevel) { return false; }
-	if (SlowFallLevel != SavedMove->SlowFallLevel) { return false; }
+	// Levels are compared too, otherwise the change/start/stop events will trigger twice causing de-sync
+	if (!AllModifierWidths([](const auto& Channels, const auto& NewChannels) { return Channels.CanCombineWith(NewChannels); },
+		ModifierChannels, SavedMove->ModifierChannels)) { return false; }
 	
 	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
 }
@@ -1448,16 +2402,7 @@ void FPredictedSavedMove::SetInitialPosition(ACharacter* C)
 		StartStamina = MoveComp->GetStamina();
 
 		// Modifiers
-		HasteLocal.SetInitialPosition(MoveComp->HasteLocal.WantsModifiers);
-		HasteCorrection.SetInitialPosition(MoveComp->HasteCorrection.WantsModifiers);
-		SlowLocal.SetInitialPosition(MoveComp->SlowLocal.WantsModifiers);
-		SlowCorrection.SetInitialPosition(MoveComp->SlowCorrection.WantsModifiers);
-		SlowFallLocal.SetInitialPosition(MoveComp->SlowFallLocal.WantsModifiers);
-		SlowFallCorrection.SetInitialPosition(MoveComp->SlowFallCorrection.WantsModifiers);
-
-		HasteLevel = MoveComp->HasteLevel;
-		SlowLevel = MoveComp->SlowLevel;
-		SlowFallLevel = MoveComp->SlowFallLevel;
+		ForEachModifierWidth([](auto& Saved, const auto& Channels) { Saved.SetInitialPosition(Channels); }, ModifierChannels, MoveComp->ModifierChannels);
 	}
 }
 
@@ -1471,12 +2416,7 @@ void FPredictedSavedMove::SetMoveFor(ACharacter* C, float InDeltaTime, FVector c
 		bWantsToSprint = MoveComp->bWantsToSprint;
 
 		// Modifiers
-		HasteLocal.SetMoveFor(MoveComp->HasteLocal.WantsModifiers);
-		HasteCorrection.SetMoveFor(MoveComp->HasteCorrection.WantsModifiers);
-		SlowLocal.SetMoveFor(MoveComp->SlowLocal.WantsModifiers);
-		SlowCorrection.SetMoveFor(MoveComp->SlowCorrection.WantsModifiers);
-		SlowFallLocal.SetMoveFor(MoveComp->SlowFallLocal.WantsModifiers);
-		SlowFallCorrection.SetMoveFor(MoveComp->SlowFallCorrection.WantsModifiers);
+		ForEachModifierWidth([](auto& Saved, const auto& Channels) { Saved.SetMoveFor(Channels); }, ModifierChannels, MoveComp->ModifierChannels);
 	}
 }
 
@@ -1489,9 +2429,7 @@ void FPredictedSavedMove::PrepMoveFor(ACharacter* C)
 		MoveComp->bWantsToWalk = bWantsToWalk;
 		MoveComp->bWantsToSprint = bWantsToSprint;
 
-		MoveComp->HasteLevel = HasteLevel;
-		MoveComp->SlowLevel = SlowLevel;
-		MoveComp->SlowFallLevel = SlowFallLevel;
+		ForEachModifierWidth([](const auto& Saved, auto& Channels) { Saved.PrepMoveFor(Channels); }, ModifierChannels, MoveComp->ModifierChannels);
 
 		MoveComp->SetStamina(StartStamina);
 		MoveComp->SetStaminaDrained(bStaminaDrained);
@@ -1506,9 +2444,7 @@ void FPredictedSavedMove::PostUpdate(ACharacter* C, EPostUpdateMode PostUpdateMo
 		EndStamina = MoveComp->GetStamina();
 
 		// Modifiers
-		HasteCorrection.PostUpdate(MoveComp->HasteCorrection.Modifiers);
-		SlowCorrection.PostUpdate(MoveComp->SlowCorrection.Modifiers);
-		SlowFallCorrection.PostUpdate(MoveComp->SlowFallCorrection.Modifiers);
+		ForEachModifierWidth([](auto& Saved, const auto& Channels) { Saved.PostUpdate(Channels); }, ModifierChannels, MoveComp->ModifierChannels);
 
 		if (PostUpdateMode == PostUpdate_Record)
 		{
@@ -1535,16 +2471,7 @@ void FPredictedSavedMove::CombineWith(const FSavedMove_Character* OldMove, AChar
 		MoveComp->SetStaminaDrained(SavedOldMove->bStaminaDrained);
 
 		// Modifiers
-		MoveComp->HasteLocal.CombineWith(SavedOldMove->HasteLocal.WantsModifiers);
-		MoveComp->HasteCorrection.CombineWith(SavedOldMove->HasteCorrection.WantsModifiers);
-		MoveComp->SlowLocal.CombineWith(SavedOldMove->SlowLocal.WantsModifiers);
-		MoveComp->SlowCorrection.CombineWith(SavedOldMove->SlowCorrection.WantsModifiers);
-		MoveComp->SlowFallLocal.CombineWith(SavedOldMove->SlowFallLocal.WantsModifiers);
-		MoveComp->SlowFallCorrection.CombineWith(SavedOldMove->SlowFallCorrection.WantsModifiers);
-
-		MoveComp->HasteLevel = SavedOldMove->HasteLevel;
-		MoveComp->SlowLevel = SavedOldMove->SlowLevel;
-		MoveComp->SlowFallLevel = SavedOldMove->SlowFallLevel;
+		ForEachModifierWidth([](const auto& Saved, auto& Channels) { Saved.CombineWith(Channels); }, SavedOldMove->ModifierChannels, MoveComp->ModifierChannels);
 	}
 }
 
@@ -1554,12 +2481,8 @@ bool FPredictedSavedMove::IsImportantMove(const FSavedMovePtr& LastAckedMove) co
 	
 	const TSharedPtr<FPredictedSavedMove>& SavedMove = StaticCastSharedPtr<FPredictedSavedMove>(LastAckedMove);
 
-	if (HasteLocal.IsImportantMove(SavedMove->HasteLocal.WantsModifiers)) { return true; }
-	if (HasteCorrection.IsImportantMove(SavedMove->HasteCorrection.WantsModifiers)) { return true; }
-	if (SlowLocal.IsImportantMove(SavedMove->SlowLocal.WantsModifiers)) { return true; }
-	if (SlowCorrection.IsImportantMove(SavedMove->SlowCorrection.WantsModifiers)) { return true; }
-	if (SlowFallLocal.IsImportantMove(SavedMove->SlowFallLocal.WantsModifiers)) { return true; }
-	if (SlowFallCorrection.IsImportantMove(SavedMove->SlowFallCorrection.WantsModifiers)) { return true; }
+	if (AnyModifierWidth([](const auto& Channels, const auto& AckedChannels) { return Channels.IsImportantMove(AckedChannels); },
+		ModifierChannels, SavedMove->ModifierChannels)) { return true; }
 	
 	return Super::IsImportantMove(LastAckedMove);
 }
@@ -1575,12 +2498,8 @@ bool UCustomMovementComponent::ClientUpdatePositionAfterServerUpdate()
 	const bool bRealSprint = bWantsToSprint;
 
 	// Modifiers
-	const TModifierStack RealHasteLocal = HasteLocal.WantsModifiers;
-	const TModifierStack RealHasteCorrection = HasteCorrection.WantsModifiers;
-	const TModifierStack RealSlowLocal = SlowLocal.WantsModifiers;
-	const TModifierStack RealSlowCorrection = SlowCorrection.WantsModifiers;
-	const TModifierStack RealSlowFallLocal = SlowFallLocal.WantsModifiers;
-	const TModifierStack RealSlowFallCorrection = SlowFallCorrection.WantsModifiers;
+	TModifierWidths<TModifierChannelWants> RealModifierWants;
+	ForEachModifierWidth([](const auto& Channels, auto& Wants) { Channels.SaveWants(Wants); }, ModifierChannels, RealModifierWants);
 
 	// Client location authority
 	const FVector ClientLoc = UpdatedComponent->GetComponentLocation();
@@ -1591,12 +2510,7 @@ bool UCustomMovementComponent::ClientUpdatePositionAfterServerUpdate()
 	bWantsToSprint = bRealSprint;
 
 	// Modifiers
-	HasteLocal.WantsModifiers = RealHasteLocal;
-	HasteCorrection.WantsModifiers = RealHasteCorrection;
-	SlowLocal.WantsModifiers = RealSlowLocal;
-	SlowCorrection.WantsModifiers = RealSlowCorrection;
-	SlowFallLocal.WantsModifiers = RealSlowFallLocal;
-	SlowFallCorrection.WantsModifiers = RealSlowFallCorrection;
+	ForEachModifierWidth([](auto& Channels, const auto& Wants) { Channels.RestoreWants(Wants); }, ModifierChannels, RealModifierWants);
 
 	// Preserve client location relative to the partial client authority we have
 	const FVector AuthLocation = FMath::Lerp<FVector>(UpdatedComponent->GetComponentLocation(), ClientLoc, ClientAuthAlpha);
@@ -1639,7 +2553,9 @@ void UCustomMovementComponent::TickCharacterPose(float DeltaTime)
 			FRootMotionMovementParams RootMotion = CharacterMesh->ConsumeRootMotion();
 			if (RootMotion.bHasRootMotion)
 			{
-				RootMotion.ScaleRootMotionTranslation(CharacterOwner->GetAnimRootMotionTranslationScale() * GetRootMotionTranslationScalar());
+				const FResolvedMovementAttributes* Attributes = GetResolvedMovementAttributes();
+				const float RootMotionScalar = Attributes ? Attributes->RootMotionTranslationScalar : GetRootMotionTranslationScalar();
+				RootMotion.ScaleRootMotionTranslation(CharacterOwner->GetAnimRootMotionTranslationScale() * RootMotionScalar);
 				RootMotionParams.Accumulate(RootMotion);
 			}
 
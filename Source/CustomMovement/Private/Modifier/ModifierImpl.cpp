@@ -1,263 +1,521 @@
 ﻿#include "Modifier/ModifierImpl.h"
-#include "Algo/Accumulate.h"
-#include "Algo/MaxElement.h"
-#include "Algo/MinElement.h"
 
 
-bool FModifierMoveData_LocalPredicted::Serialize(FArchive& Ar, const FString& ErrorName, uint8 MaxSerializedModifiers)
+template<typename TLevel>
+bool TModifierMoveData_LocalPredicted<TLevel>::Serialize(FArchive& Ar, const FString& ErrorName, const FModifierStackNetFormat& WantsFormat)
 {
-	return FModifierStatics::NetSerialize(WantsModifiers, Ar, ErrorName, MaxSerializedModifiers);
+	return FModifierStatics::NetSerialize(WantsModifiers, Ar, ErrorName, WantsFormat);
 }
 
-bool FModifierMoveData_WithCorrection::Serialize(FArchive& Ar, const FString& ErrorName, uint8 MaxSerializedModifiers)
+template<typename TLevel>
+bool TModifierMoveData_WithCorrection<TLevel>::Serialize(FArchive& Ar, const FString& ErrorName, const FModifierStackNetFormat& WantsFormat, const FModifierStackNetFormat& Format)
 {
-	return FModifierStatics::NetSerialize(WantsModifiers, Ar, ErrorName, MaxSerializedModifiers) && FModifierStatics::NetSerialize(Modifiers, Ar, ErrorName, MaxSerializedModifiers);
+	return FModifierStatics::NetSerialize(WantsModifiers, Ar, ErrorName, WantsFormat) && FModifierStatics::NetSerialize(Modifiers, Ar, ErrorName, Format);
 }
 
-bool FModifierMoveData_ServerInitiated::Serialize(FArchive& Ar, const FString& ErrorName, uint8 MaxSerializedModifiers)
+template<typename TLevel>
+bool TModifierMoveData_ServerInitiated<TLevel>::Serialize(FArchive& Ar, const FString& ErrorName, const FModifierStackNetFormat& Format)
 {
-	return FModifierStatics::NetSerialize(Modifiers, Ar, ErrorName, MaxSerializedModifiers);
+	return FModifierStatics::NetSerialize(Modifiers, Ar, ErrorName, Format);
 }
 
-TModSize FMovementModifier::GetNumWantedModifiersByLevel(TModSize Level) const
+template<typename TLevel>
+uint8 TMovementModifier<TLevel>::GetNumWantedModifiersByLevel(TLevel Level) const
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(FMovementModifier::GetNumWantedModifiersByLevel);
-	
-	return WantsModifiers.FilterByPredicate([Level](uint8 ModifierLevel)
-	{
-		return ModifierLevel == Level;
-	}).Num();
+
+	return WantsCounts.GetCount(Level);
 }
 
-TModSize FMovementModifier::GetNumModifiersByLevel(TModSize Level) const
+template<typename TLevel>
+uint8 TMovementModifier<TLevel>::GetNumModifiersByLevel(TLevel Level) const
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(FMovementModifier::GetNumModifiersByLevel);
-	
-	return Modifiers.FilterByPredicate([Level](uint8 ModifierLevel)
-	{
-		return ModifierLevel == Level;
-	}).Num();
+
+	return ModifierCounts.GetCount(Level);
+}
+
+template<typename TLevel>
+int32 TMovementModifier<TLevel>::GetNumLimitedModifiers(int32 NumModifiers, int32& RemainingModifiers)
+{
+	// If MaxModifiers is 0 or less, we can't have any modifiers, otherwise keep the newest entries
+	const int32 NumKept = FMath::Clamp(NumModifiers, 0, FMath::Max(RemainingModifiers, 0));
+	RemainingModifiers = FMath::Max(RemainingModifiers - NumKept, 0);
+	return NumKept;
 }
 
-void FMovementModifier::LimitNumModifiers(TModifierStack& Modifiers, int32& RemainingModifiers)
+template<typename TLevel>
+void TMovementModifier<TLevel>::LimitNumModifiers(TModifierLevelStack<TLevel>& Modifiers, int32& RemainingModifiers)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(FMovementModifier::LimitNumModifiers);
-	
-	if (Modifiers.Num() > RemainingModifiers)
-	{
-		// Limit the number of modifiers to the maximum allowed
-		if (RemainingModifiers <= 0)
-		{
-			// If MaxModifiers is 0 or less, we can't have any modifiers
-			Modifiers.Reset();
-		}
-		else
-		{
-			// Remove the oldest entries (from the start)
-			const int32 NumToRemove = Modifiers.Num() - RemainingModifiers;
-			Modifiers.RemoveAt(0, NumToRemove, EAllowShrinking::No);
-		}
-	}
 
-	RemainingModifiers = FMath::Max(RemainingModifiers - Modifiers.Num(), 0);
+	// Remove the oldest entries (from the start) -- this only advances the head of the ring
+	const int32 NumKept = GetNumLimitedModifiers(Modifiers.Num(), RemainingModifiers);
+	Modifiers.RemoveOldest(Modifiers.Num() - NumKept);
 }
 
-bool FMovementModifier::UpdateMovementState(bool bAllowedInCurrentState, bool bClampMax, int32& Remaining)
+template<typename TLevel>
+bool TMovementModifier<TLevel>::UpdateMovementState(bool bAllowedInCurrentState, bool bClampMax, int32& Remaining)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(FMovementModifier::UpdateMovementState);
-	
+
 	// Only update the modifiers if the current state allows it
-	TModifierStack CurrentModifiers = bAllowedInCurrentState ? WantsModifiers : TModifierStack();
+	int32 NumAllowed = bAllowedInCurrentState ? WantsModifiers.Num() : 0;
 
 	// Clamp the number of modifiers to the maximum allowed -- this removes old modifiers first
 	// Note: There may be potential for de-sync if client removes server modifiers out of order (cross that bridge when we get there)
 	if (bAllowedInCurrentState && bClampMax)
 	{
-		LimitNumModifiers(CurrentModifiers, Remaining);
+		NumAllowed = GetNumLimitedModifiers(NumAllowed, Remaining);
 	}
 
+	// View of the newest allowed modifiers, without copying the stack
+	const TModifierLevelStackView<TLevel> CurrentModifiers = WantsModifiers.Newest(NumAllowed);
+
 	// If the modifiers have changed, update the data
 	if (Modifiers != CurrentModifiers)
 	{
-		Modifiers = CurrentModifiers;
+		Modifiers.Assign(CurrentModifiers);
+		ModifierCounts.Rebuild(Modifiers);
 		return true;
 	}
 	return false;
 }
 
-bool FModifierStatics::NetSerialize(TModifierStack& Modifiers, FArchive& Ar, const FString& ErrorName, uint8 MaxSerializedModifiers)
+namespace ModifierNetSerialize
+{
+	/** Serializes a single level at the width of the format, failing on levels the channel doesn't have */
+	static bool SerializeLevel(uint32& Level, FArchive& Ar, const FString& ErrorName, const FModifierStackNetFormat& Format)
+	{
+		if (Ar.IsSaving() && !ensureMsgf(Level < static_cast<uint32>(Format.NumLevels),
+			TEXT("Serializing modifier %s level %u when there are %d levels -- Check the level tags"), *ErrorName, Level, Format.NumLevels))
+		{
+			Ar.SetError();
+			return false;
+		}
+
+		if (Format.LevelBits > 0)
+		{
+			Ar.SerializeBits(&Level, Format.LevelBits);
+		}
+
+		if (Ar.IsLoading() && Level >= static_cast<uint32>(Format.NumLevels))
+		{
+			Ar.SetError();
+			return false;
+		}
+		return true;
+	}
+}
+
+template<typename TLevel>
+bool FModifierStatics::NetSerializeLevel(TLevel& Level, FArchive& Ar, const FString& ErrorName, const FModifierStackNetFormat& Format)
+{
+	uint32 Value = Ar.IsSaving() ? static_cast<uint32>(Level) : 0;
+	if (!ModifierNetSerialize::SerializeLevel(Value, Ar, ErrorName, Format))
+	{
+		return false;
+	}
+
+	if (Ar.IsLoading())
+	{
+		Level = static_cast<TLevel>(Value);
+	}
+	return !Ar.IsError();
+}
+
+template<typename TLevel>
+bool FModifierStatics::NetSerialize(TModifierLevelStack<TLevel>& Modifiers, FArchive& Ar, const FString& ErrorName, const FModifierStackNetFormat& Format)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(FModifierStatics::NetSerialize);
-	
-	// Don't serialize modifier stack if the max is 0
-	if (MaxSerializedModifiers <= 1)
+
+	// Don't serialize the modifier stack if it can't hold anything
+	if (Format.MaxModifiers == 0 || Format.NumLevels == 0)
 	{
+		if (Ar.IsLoading())
+		{
+			Modifiers.Reset();
+		}
 		return !Ar.IsError();
 	}
-	
-	// Serialize the number of elements
-	TModSize NumModifiers = Modifiers.Num();
+
+	// Serialize the number of elements, the newest are kept if the stack holds more than the format allows
+	uint32 NumModifiers = 0;
 	if (Ar.IsSaving())
 	{
-		NumModifiers = FMath::Min(MaxSerializedModifiers, NumModifiers);
+		NumModifiers = FMath::Min<uint32>(Modifiers.Num(), Format.MaxModifiers);
 	}
-	Ar << NumModifiers;
+	Ar.SerializeBits(&NumModifiers, Format.CountBits);
 
-	// Resize the array if needed
 	if (Ar.IsLoading())
 	{
-		if (!ensureMsgf(NumModifiers <= MaxSerializedModifiers,
-			TEXT("Deserializing modifier %s array with %d elements when max is %d -- Check packet serialization logic"), *ErrorName, NumModifiers, MaxSerializedModifiers))
+		if (!ensureMsgf(NumModifiers <= Format.MaxModifiers,
+			TEXT("Deserializing modifier %s array with %u elements when max is %d -- Check packet serialization logic"), *ErrorName, NumModifiers, Format.MaxModifiers))
 		{
-			NumModifiers = MaxSerializedModifiers;
+			Ar.SetError();
+			return false;
 		}
-		Modifiers.SetNum(NumModifiers);
+		Modifiers.Reset();
 	}
 
-	// Serialize the elements
-	for (TModSize i = 0; i < NumModifiers; ++i)
+	// Serialize the elements at the level width, pushed when loading so the stack fingerprint follows
+	const int32 First = Ar.IsSaving() ? Modifiers.Num() - static_cast<int32>(NumModifiers) : 0;
+	for (int32 i = 0; i < static_cast<int32>(NumModifiers); ++i)
 	{
-		Ar << Modifiers[i];
+		uint32 Level = Ar.IsSaving() ? static_cast<uint32>(Modifiers[First + i]) : 0;
+		if (!ModifierNetSerialize::SerializeLevel(Level, Ar, ErrorName, Format))
+		{
+			return false;
+		}
+
+		if (Ar.IsLoading())
+		{
+			Modifiers.Add(static_cast<TLevel>(Level));
+		}
 	}
 
 	return !Ar.IsError();
 }
 
-TModSize FModifierStatics::UpdateModifierLevel(EModifierLevelMethod Method, const TModifierStack& Modifiers,
-	TModSize MaxLevel, TModSize InvalidLevel)
+template<typename TLevel>
+bool FModifierStatics::NetSerializeDelta(TModifierLevelStack<TLevel>& Modifiers, const TModifierLevelStack<TLevel>* Baseline, FArchive& Ar,
+	const FString& ErrorName, const FModifierStackNetFormat& Format)
 {
-	TRACE_CPUPROFILER_EVENT_SCOPE(FModifierStatics::UpdateModifierLevel);
-	
-	if (Modifiers.IsEmpty())
-	{
-		return InvalidLevel;
-	}
+	TRACE_CPUPROFILER_EVENT_SCOPE(FModifierStatics::NetSerializeDelta);
 
-	TModSize NewLevel;
+	check(Baseline || Ar.IsLoading());
 
-	switch (Method)
+	// Don't serialize the modifier stack if it can't hold anything
+	if (Format.MaxModifiers == 0 || Format.NumLevels == 0)
 	{
-	case EModifierLevelMethod::Max:
-		NewLevel = *Algo::MaxElement(Modifiers);
-		break;
+		if (Ar.IsLoading())
+		{
+			Modifiers.Reset();
+		}
+		return !Ar.IsError();
+	}
 
-	case EModifierLevelMethod::Min:
-		NewLevel = *Algo::MinElement(Modifiers);
-		break;
+	// Both ends only see the newest elements the format allows, as NetSerialize would send them
+	const int32 NumBase = Baseline ? FMath::Min(Baseline->Num(), static_cast<int32>(Format.MaxModifiers)) : 0;
+	const int32 BaseStart = Baseline ? Baseline->Num() - NumBase : 0;
 
-	case EModifierLevelMethod::Stack:
+	uint8 bChanged = 0;
+	uint32 NumDropped = 0;
+	uint32 NumPopped = 0;
+	uint32 NumPushed = 0;
+	int32 NumKept = 0;
+	if (Ar.IsSaving())
+	{
+		const TModifierLevelStackView<TLevel> Target = Modifiers.Newest(Format.MaxModifiers);
+		if (NumBase == Baseline->Num() && Target.Num() == Modifiers.Num())
+		{
+			bChanged = Modifiers != *Baseline;
+		}
+		else
 		{
-			uint64 Total = 0;
-			for (const TModSize& Level : Modifiers)
+			bChanged = NumBase != Target.Num();
+			for (int32 i = 0; !bChanged && i < NumBase; ++i)
 			{
-				// We are only counting the number of modifiers, so we add 1 because levels are 0-based
-				Total += Level + 1;
+				bChanged = (*Baseline)[BaseStart + i] != Target[i];
 			}
-
-			// Subtract 1 to convert back to 0-based level
-			NewLevel = Total > 0 ? Total - 1 : 0;
 		}
-		break;
 
-	case EModifierLevelMethod::Average:
+		if (bChanged)
 		{
-			uint64 Total = 0;
-			for (const TModSize& Level : Modifiers)
+			// Keep the longest run of the baseline that the target starts with, once the oldest elements are dropped
+			for (int32 Drop = 0; Drop + NumKept < NumBase; ++Drop)
 			{
-				// We don't add 1 here because we are averaging the levels, not counting them
-				Total += Level;
+				int32 Run = 0;
+				while (Drop + Run < NumBase && Run < Target.Num() && (*Baseline)[BaseStart + Drop + Run] == Target[Run])
+				{
+					Run++;
+				}
+				if (Run > NumKept)
+				{
+					NumKept = Run;
+					NumDropped = Drop;
+				}
 			}
-			NewLevel = static_cast<TModSize>(Total / Modifiers.Num());
+			NumPopped = NumBase - NumDropped - NumKept;
+			NumPushed = Target.Num() - NumKept;
 		}
-		break;
+	}
 
-	default:
-		return InvalidLevel;
+	Ar.SerializeBits(&bChanged, 1);
+	if (!bChanged)
+	{
+		if (Ar.IsLoading())
+		{
+			if (Baseline)
+			{
+				Modifiers.Assign(TModifierLevelStackView<TLevel>(*Baseline, BaseStart, NumBase));
+			}
+			else
+			{
+				Modifiers.Reset();
+			}
+		}
+		return !Ar.IsError();
 	}
 
-	// Clamp to max allowed
-	return FMath::Clamp(NewLevel, 0, MaxLevel);
-}
+	Ar.SerializeBits(&NumDropped, Format.CountBits);
+	Ar.SerializeBits(&NumPopped, Format.CountBits);
+	Ar.SerializeBits(&NumPushed, Format.CountBits);
 
-TModSize FModifierStatics::CombineModifierLevels(EModifierLevelMethod Method, const TModifierStack& ModifierLevels,
-	TModSize MaxLevel, TModSize InvalidLevel)
-{
-	TRACE_CPUPROFILER_EVENT_SCOPE(FModifierStatics::CombineModifierLevels);
-	
-	if (ModifierLevels.IsEmpty())
+	if (Ar.IsLoading())
 	{
-		return InvalidLevel;
-	}
+		NumKept = NumBase - static_cast<int32>(NumDropped) - static_cast<int32>(NumPopped);
+		if (!ensureMsgf(NumPushed <= Format.MaxModifiers && (!Baseline || (NumKept >= 0 && NumKept + static_cast<int32>(NumPushed) <= Format.MaxModifiers)),
+			TEXT("Deserializing modifier %s edits (drop %u, pop %u, push %u) that don't fit the baseline of %d elements -- Check packet serialization logic"),
+			*ErrorName, NumDropped, NumPopped, NumPushed, NumBase))
+		{
+			Ar.SetError();
+			return false;
+		}
 
-	TModSize NewLevel;
+		if (Baseline)
+		{
+			Modifiers.Assign(TModifierLevelStackView<TLevel>(*Baseline, BaseStart + NumDropped, NumKept));
+		}
+		else
+		{
+			Modifiers.Reset();
+		}
+	}
 
-	switch (Method)
+	// The pushed elements are the newest of the target
+	const int32 First = Ar.IsSaving() ? Modifiers.Num() - static_cast<int32>(NumPushed) : 0;
+	for (int32 i = 0; i < static_cast<int32>(NumPushed); ++i)
 	{
-	case EModifierLevelMethod::Max:
-		NewLevel = *Algo::MaxElement(ModifierLevels);
-		break;
+		uint32 Level = Ar.IsSaving() ? static_cast<uint32>(Modifiers[First + i]) : 0;
+		if (!ModifierNetSerialize::SerializeLevel(Level, Ar, ErrorName, Format))
+		{
+			return false;
+		}
+
+		if (Ar.IsLoading() && Baseline)
+		{
+			Modifiers.Add(static_cast<TLevel>(Level));
+		}
+	}
 
-	case EModifierLevelMethod::Min:
-		NewLevel = *Algo::MinElement(ModifierLevels);
-		break;
+	return !Ar.IsError();
+}
 
-	case EModifierLevelMethod::Stack:
+namespace ModifierLevelKernels
+{
+	/*
+	 * One kernel per EModifierLevelMethod
+	 * Accumulate() is a plain branchless loop over contiguous levels so the compiler can vectorize it (max/min/sum)
+	 * Finalize() clamps the accumulated value to the max level
+	 */
+
+	template<typename TLevel>
+	struct TMaxKernel
+	{
+		using FState = TLevel;
+		static FState Init() { return 0; }
+		static void Accumulate(FState& State, TArrayView<const TLevel> Levels)
 		{
-			uint64 Total = 0;
-			for (const TModSize& Level : ModifierLevels)
+			TLevel Result = State;
+			for (const TLevel Level : Levels)
 			{
-				// We are only counting the number of modifiers, so we add 1 because levels are 0-based
-				Total += Level + 1;
+				Result = Level > Result ? Level : Result;
 			}
+			State = Result;
+		}
+		static TLevel Finalize(FState State, int32 Num, TLevel MaxLevel) { return FMath::Min(State, MaxLevel); }
+		static TLevel FromCounts(const TModifierLevelCounts<TLevel>& Counts, TLevel MaxLevel) { return FMath::Min(Counts.GetMax(), MaxLevel); }
+	};
 
-			// Subtract 1 to convert back to 0-based level
-			NewLevel = Total > 0 ? Total - 1 : 0;
+	template<typename TLevel>
+	struct TMinKernel
+	{
+		using FState = TLevel;
+		static FState Init() { return TNumericLimits<TLevel>::Max(); }
+		static void Accumulate(FState& State, TArrayView<const TLevel> Levels)
+		{
+			TLevel Result = State;
+			for (const TLevel Level : Levels)
+			{
+				Result = Level < Result ? Level : Result;
+			}
+			State = Result;
 		}
-		break;
+		static TLevel Finalize(FState State, int32 Num, TLevel MaxLevel) { return FMath::Min(State, MaxLevel); }
+		static TLevel FromCounts(const TModifierLevelCounts<TLevel>& Counts, TLevel MaxLevel) { return FMath::Min(Counts.GetMin(), MaxLevel); }
+	};
 
-	case EModifierLevelMethod::Average:
+	template<typename TLevel>
+	struct TSumKernelBase
+	{
+		using FState = uint32;
+		static FState Init() { return 0; }
+		static void Accumulate(FState& State, TArrayView<const TLevel> Levels)
 		{
-			uint64 Total = 0;
-			for (const TModSize& Level : ModifierLevels)
+			uint32 Result = State;
+			for (const TLevel Level : Levels)
 			{
-				Total += Level;
+				Result += Level;
 			}
-			NewLevel = static_cast<TModSize>(Total / ModifierLevels.Num());
+			State = Result;
+		}
+	};
+
+	template<typename TLevel>
+	struct TStackKernel : TSumKernelBase<TLevel>
+	{
+		// Each modifier adds its 1-based level, then subtract 1 to convert back to 0-based level
+		static TLevel Finalize(uint32 Sum, int32 Num, TLevel MaxLevel)
+		{
+			return static_cast<TLevel>(FMath::Min<uint64>(static_cast<uint64>(Sum) + Num - 1, MaxLevel));
 		}
-		break;
+		static TLevel FromCounts(const TModifierLevelCounts<TLevel>& Counts, TLevel MaxLevel) { return Finalize(Counts.GetSum(), Counts.Num(), MaxLevel); }
+	};
+
+	template<typename TLevel>
+	struct TAverageKernel : TSumKernelBase<TLevel>
+	{
+		static TLevel Finalize(uint32 Sum, int32 Num, TLevel MaxLevel)
+		{
+			return static_cast<TLevel>(FMath::Min<uint32>(Sum / Num, MaxLevel));
+		}
+		static TLevel FromCounts(const TModifierLevelCounts<TLevel>& Counts, TLevel MaxLevel) { return Finalize(Counts.GetSum(), Counts.Num(), MaxLevel); }
+	};
+
+	template<typename TLevel, typename KernelType>
+	static TLevel ReduceStack(const TModifierLevelStack<TLevel>& Levels, TLevel MaxLevel, TLevel InvalidLevel)
+	{
+		if (Levels.IsEmpty())
+		{
+			return InvalidLevel;
+		}
+
+		// The ring buffer may wrap, so reduce both contiguous spans
+		TArrayView<const TLevel> First, Second;
+		Levels.GetSpans(First, Second);
 
-	default:
-		return InvalidLevel;
+		typename KernelType::FState State = KernelType::Init();
+		KernelType::Accumulate(State, First);
+		KernelType::Accumulate(State, Second);
+		return KernelType::Finalize(State, Levels.Num(), MaxLevel);
 	}
 
-	// Clamp to max allowed
-	return FMath::Clamp(NewLevel, 0, MaxLevel);
+	template<typename TLevel, typename KernelType>
+	static TLevel ReduceCounts(const TModifierLevelCounts<TLevel>& Counts, TLevel MaxLevel, TLevel InvalidLevel)
+	{
+		return Counts.IsEmpty() ? InvalidLevel : KernelType::FromCounts(Counts, MaxLevel);
+	}
+
+	template<typename TLevel, template<typename> class KernelType>
+	static constexpr TModifierLevelKernel<TLevel> MakeKernel()
+	{
+		return { &ReduceStack<TLevel, KernelType<TLevel>>, &ReduceCounts<TLevel, KernelType<TLevel>> };
+	}
+
+	template<typename TLevel>
+	static TLevel ReduceStackInvalid(const TModifierLevelStack<TLevel>&, TLevel, TLevel InvalidLevel) { return InvalidLevel; }
+
+	template<typename TLevel>
+	static TLevel ReduceCountsInvalid(const TModifierLevelCounts<TLevel>&, TLevel, TLevel InvalidLevel) { return InvalidLevel; }
+
+	/** Indexed by EModifierLevelMethod */
+	template<typename TLevel>
+	static constexpr TModifierLevelKernel<TLevel> Kernels[] =
+	{
+		MakeKernel<TLevel, TMaxKernel>(),
+		MakeKernel<TLevel, TMinKernel>(),
+		MakeKernel<TLevel, TStackKernel>(),
+		MakeKernel<TLevel, TAverageKernel>(),
+	};
+
+	template<typename TLevel>
+	static constexpr TModifierLevelKernel<TLevel> InvalidKernel = { &ReduceStackInvalid<TLevel>, &ReduceCountsInvalid<TLevel> };
+}
+
+template<typename TLevel>
+const TModifierLevelKernel<TLevel>& FModifierStatics::GetLevelKernel(EModifierLevelMethod Method)
+{
+	const int32 Index = static_cast<int32>(Method);
+	return Index < UE_ARRAY_COUNT(ModifierLevelKernels::Kernels<TLevel>) ? ModifierLevelKernels::Kernels<TLevel>[Index] : ModifierLevelKernels::InvalidKernel<TLevel>;
+}
+
+template<typename TLevel>
+TLevel FModifierStatics::UpdateModifierLevel(EModifierLevelMethod Method, const TModifierLevelStack<TLevel>& Modifiers,
+	TLevel MaxLevel, TLevel InvalidLevel)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FModifierStatics::UpdateModifierLevel);
+
+	return GetLevelKernel<TLevel>(Method).ReduceStack(Modifiers, MaxLevel, InvalidLevel);
+}
+
+template<typename TLevel>
+TLevel FModifierStatics::UpdateModifierLevel(EModifierLevelMethod Method, const TModifierLevelCounts<TLevel>& Counts,
+	TLevel MaxLevel, TLevel InvalidLevel)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FModifierStatics::UpdateModifierLevelFromCounts);
+
+	return GetLevelKernel<TLevel>(Method).ReduceCounts(Counts, MaxLevel, InvalidLevel);
+}
+
+template<typename TLevel>
+TLevel FModifierStatics::CombineModifierLevels(EModifierLevelMethod Method, const TModifierLevelStack<TLevel>& ModifierLevels,
+	TLevel MaxLevel, TLevel InvalidLevel)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FModifierStatics::CombineModifierLevels);
+
+	return GetLevelKernel<TLevel>(Method).ReduceStack(ModifierLevels, MaxLevel, InvalidLevel);
 }
 
-bool FModifierStatics::ProcessModifiers(TModSize& CurrentLevel, EModifierLevelMethod Method,
-	const TArray<FGameplayTag>& LevelTags, bool bLimitMaxModifiers, int32 MaxModifiers, TModSize InvalidLevel,
-	const TArray<FMovementModifier*>& Modifiers, const TFunctionRef<bool()>& CanActivateCallback)
+template<typename TLevel>
+bool FModifierStatics::ProcessModifiers(TLevel& CurrentLevel, EModifierLevelMethod Method,
+	const TArray<FGameplayTag>& LevelTags, bool bLimitMaxModifiers, int32 MaxModifiers, TLevel InvalidLevel,
+	TArrayView<TMovementModifier<TLevel>* const> Modifiers, const TFunctionRef<bool()>& CanActivateCallback, TModifierProcessCache<TLevel>& Cache)
 {
 	TRACE_CPUPROFILER_EVENT_SCOPE(FModifierStatics::ProcessModifiers);
-	
-	const TModSize PrevLevel = CurrentLevel;
 
-	// Determine the maximum level based on the available tags
-	const TModSize MaxLevel = LevelTags.Num() > 0 ? static_cast<TModSize>(LevelTags.Num() - 1) : 0;
+	const TLevel PrevLevel = CurrentLevel;
+
+	// Determine the maximum level based on the available tags, the sentinel is never a valid level
+	const TLevel MaxLevel = static_cast<TLevel>(FMath::Clamp<int32>(LevelTags.Num() - 1, 0, TModifierLevelTraits<TLevel>::None - 1));
 
-	// Track modifier data
+	// The activation state is the same for every modifier of this type
+	const bool bCanActivate = CanActivateCallback();
+
+	// The level method is resolved once for the whole modifier type, when it is registered, and again only if the method changed since
+	if (!Cache.Kernel || Cache.KernelMethod != Method)
+	{
+		Cache.Kernel = &GetLevelKernel<TLevel>(Method);
+		Cache.KernelMethod = Method;
+	}
+	const TModifierLevelKernel<TLevel>& Kernel = *Cache.Kernel;
+
+	// Nothing was edited and the inputs are the same, so the result is the same as last time
+	uint32 Generation = 0;
+	for (const TMovementModifier<TLevel>* Modifier : Modifiers)
+	{
+		Generation += Modifier->WantsGeneration;
+	}
+	if (Cache.bValid && Cache.Generation == Generation && Cache.bCanActivate == bCanActivate && Cache.Method == Method
+		&& Cache.MaxLevel == MaxLevel && Cache.bLimitMaxModifiers == bLimitMaxModifiers && Cache.MaxModifiers == MaxModifiers)
+	{
+		CurrentLevel = Cache.Level;
+		return CurrentLevel != PrevLevel;
+	}
+
+	// Track modifier data, the combined levels are stored inline so processing never allocates
 	bool bStateChanged = false;
-	TArray<TModSize> Levels;
+	TModifierLevelStack<TLevel> Levels;
 	int32 Remaining = MaxModifiers;
 
 	// Iterate through all modifiers and update their state
-	for (FMovementModifier* Modifier : Modifiers)
+	for (TMovementModifier<TLevel>* Modifier : Modifiers)
 	{
 		// Track if any state changed
-		bStateChanged |= Modifier->UpdateMovementState(CanActivateCallback(), bLimitMaxModifiers, Remaining);
+		bStateChanged |= Modifier->UpdateMovementState(bCanActivate, bLimitMaxModifiers, Remaining);
 
 		// Always read and process the current modifier data
-		const TModSize NewLevel = UpdateModifierLevel(Method, Modifier->Modifiers, MaxLevel, InvalidLevel);
+		const TLevel NewLevel = Kernel.ReduceCounts(Modifier->ModifierCounts, MaxLevel, InvalidLevel);
 		if (NewLevel != InvalidLevel)
 		{
 			Levels.Add(NewLevel);
@@ -265,7 +523,40 @@ bool FModifierStatics::ProcessModifiers(TModSize& CurrentLevel, EModifierLevelMe
 	}
 
 	// Combine all active modifier levels
-	CurrentLevel = Levels.Num() > 0 ? CombineModifierLevels(Method, Levels, MaxLevel, InvalidLevel) : InvalidLevel;
+	CurrentLevel = Kernel.ReduceStack(Levels, MaxLevel, InvalidLevel);
+
+	// Cache the result until a modifier is edited or the inputs change
+	Cache.Generation = Generation;
+	Cache.MaxModifiers = MaxModifiers;
+	Cache.Method = Method;
+	Cache.bLimitMaxModifiers = bLimitMaxModifiers;
+	Cache.MaxLevel = MaxLevel;
+	Cache.bCanActivate = bCanActivate;
+	Cache.Level = CurrentLevel;
+	Cache.bValid = true;
 
 	return bStateChanged || CurrentLevel != PrevLevel;
-}
\ No newline at end of file
+}
+
+/*
+ * Supported level widths, see TModifierLevelTraits
+ */
+#define CM_INSTANTIATE_MODIFIER_LEVEL(TLevel) \
+	template struct TModifierMoveData_LocalPredicted<TLevel>; \
+	template struct TModifierMoveData_WithCorrection<TLevel>; \
+	template struct TModifierMoveData_ServerInitiated<TLevel>; \
+	template struct TMovementModifier<TLevel>; \
+	template CUSTOMMOVEMENT_API bool FModifierStatics::NetSerialize<TLevel>(TModifierLevelStack<TLevel>&, FArchive&, const FString&, const FModifierStackNetFormat&); \
+	template CUSTOMMOVEMENT_API bool FModifierStatics::NetSerializeLevel<TLevel>(TLevel&, FArchive&, const FString&, const FModifierStackNetFormat&); \
+	template CUSTOMMOVEMENT_API bool FModifierStatics::NetSerializeDelta<TLevel>(TModifierLevelStack<TLevel>&, const TModifierLevelStack<TLevel>*, FArchive&, const FString&, const FModifierStackNetFormat&); \
+	template CUSTOMMOVEMENT_API const TModifierLevelKernel<TLevel>& FModifierStatics::GetLevelKernel<TLevel>(EModifierLevelMethod); \
+	template CUSTOMMOVEMENT_API TLevel FModifierStatics::UpdateModifierLevel<TLevel>(EModifierLevelMethod, const TModifierLevelStack<TLevel>&, TLevel, TLevel); \
+	template CUSTOMMOVEMENT_API TLevel FModifierStatics::UpdateModifierLevel<TLevel>(EModifierLevelMethod, const TModifierLevelCounts<TLevel>&, TLevel, TLevel); \
+	template CUSTOMMOVEMENT_API TLevel FModifierStatics::CombineModifierLevels<TLevel>(EModifierLevelMethod, const TModifierLevelStack<TLevel>&, TLevel, TLevel); \
+	template CUSTOMMOVEMENT_API bool FModifierStatics::ProcessModifiers<TLevel>(TLevel&, EModifierLevelMethod, const TArray<FGameplayTag>&, bool, int32, TLevel, \
+		TArrayView<TMovementModifier<TLevel>* const>, const TFunctionRef<bool()>&, TModifierProcessCache<TLevel>&);
+
+CM_INSTANTIATE_MODIFIER_LEVEL(uint8)
+CM_INSTANTIATE_MODIFIER_LEVEL(uint16)
+
+#undef CM_INSTANTIATE_MODIFIER_LEVEL
\ No newline at end of file
@@ -0,0 +1,44 @@
+﻿#include "Modifier/ModifierTypes.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(ModifierTypes)
+
+bool FModifierCurveLUT::Bake(const FRichCurve& Curve, int32 NumSamples)
+{
+	Reset();
+
+	if (Curve.GetNumKeys() == 0 || Curve.PreInfinityExtrap != RCCE_Constant || Curve.PostInfinityExtrap != RCCE_Constant)
+	{
+		return false;
+	}
+
+	Curve.GetTimeRange(MinTime, MaxTime);
+	NumSamples = FMath::Max(NumSamples, 2);
+
+	const float Step = (MaxTime - MinTime) / (NumSamples - 1);
+	InvStep = Step > UE_KINDA_SMALL_NUMBER ? 1.f / Step : 0.f;
+
+	Samples.SetNumUninitialized(NumSamples);
+	for (int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		Samples[Index] = Curve.Eval(MinTime + Step * Index);
+	}
+	return true;
+}
+
+void FFallingModifierParams::BakeCurves()
+{
+	GravityScalarFallVelocityLUT.Reset();
+
+	if (!bGravityScalarFromVelocityZ)
+	{
+		return;
+	}
+
+	// Validated once here rather than on every evaluation
+	if (!ensureMsgf(GravityScalarFallVelocityCurve != nullptr, TEXT("GravityScalarFallVelocityCurve must be set")))
+	{
+		return;
+	}
+
+	GravityScalarFallVelocityLUT.Bake(GravityScalarFallVelocityCurve->FloatCurve);
+}
@@ -0,0 +1,357 @@
+﻿#include "CustomMovementComponent.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "HAL/IConsoleManager.h"
+#include "Serialization/BitWriter.h"
+#include "Tags/CM_GameplayTags.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogPredictedMovement, Log, All);
+
+namespace PredMovementBenchmark
+{
+	/** Compares adding a Slow to 10/100/1000 components one by one, batched, and batched on worker threads */
+	static void BenchmarkModifierBatch(const TArray<FString>& Args)
+	{
+		const int32 Iterations = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100, 1);
+		const FGameplayTag Tag = CustomMovementGameplayTags::CustomMovement_Modifier_Slowdown;
+
+		TArray<UCustomMovementComponent*> Components;
+		for (int32 Index = 0; Index < 1000; ++Index)
+		{
+			Components.Add(NewObject<UCustomMovementComponent>(GetTransientPackage()));
+		}
+
+		for (const int32 NumTargets : { 10, 100, 1000 })
+		{
+			const TArray<UCustomMovementComponent*> Targets(Components.GetData(), NumTargets);
+			const auto ClearTargets = [&Targets]() { for (UCustomMovementComponent* Component : Targets) { Component->ClearSlow(); } };
+
+			double Individual = 0.0;
+			double Batch = 0.0;
+			double ParallelBatch = 0.0;
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				double Start = FPlatformTime::Seconds();
+				for (UCustomMovementComponent* Component : Targets)
+				{
+					Component->SetSlowByTag(Tag);
+				}
+				Individual += FPlatformTime::Seconds() - Start;
+				ClearTargets();
+
+				Start = FPlatformTime::Seconds();
+				UCustomMovementComponent::SetSlowByTagBatch(Targets, Tag, false, 0.f, false);
+				Batch += FPlatformTime::Seconds() - Start;
+				ClearTargets();
+
+				Start = FPlatformTime::Seconds();
+				UCustomMovementComponent::SetSlowByTagBatch(Targets, Tag, false, 0.f, true);
+				ParallelBatch += FPlatformTime::Seconds() - Start;
+				ClearTargets();
+			}
+
+			const double ToMicroseconds = 1000000.0 / Iterations;
+			UE_LOG(LogPredictedMovement, Display, TEXT("%4d targets: individual %.2f us, batch %.2f us, parallel batch %.2f us"),
+				NumTargets, Individual * ToMicroseconds, Batch * ToMicroseconds, ParallelBatch * ToMicroseconds);
+		}
+
+		for (UCustomMovementComponent* Component : Components)
+		{
+			Component->MarkAsGarbage();
+		}
+	}
+
+	/** Compares evaluating a gravity scalar curve directly and through its baked lookup table */
+	static void BenchmarkCurveLUT(const TArray<FString>& Args)
+	{
+		const int32 NumEvaluations = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000000, 1);
+
+		// A typical slow fall curve, weak gravity when falling fast and normal gravity when rising
+		UCurveFloat* Curve = NewObject<UCurveFloat>(GetTransientPackage());
+		Curve->FloatCurve.AddKey(-4000.f, 0.1f);
+		Curve->FloatCurve.AddKey(-1500.f, 0.25f);
+		Curve->FloatCurve.AddKey(-200.f, 0.6f);
+		Curve->FloatCurve.AddKey(0.f, 1.f);
+		Curve->FloatCurve.AddKey(1000.f, 1.f);
+		for (auto It = Curve->FloatCurve.GetKeyHandleIterator(); It; ++It)
+		{
+			Curve->FloatCurve.SetKeyInterpMode(*It, RCIM_Cubic);
+		}
+
+		FModifierCurveLUT LUT;
+		LUT.Bake(Curve->FloatCurve);
+
+		// Sweep the fall velocities the curve covers, and a bit beyond it
+		const auto VelocityZ = [NumEvaluations](int32 Index) { return FMath::Lerp(-5000.f, 2000.f, static_cast<float>(Index) / NumEvaluations); };
+
+		float Sum = 0.f;
+		double Start = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumEvaluations; ++Index)
+		{
+			Sum += Curve->GetFloatValue(VelocityZ(Index));
+		}
+		const double CurveTime = FPlatformTime::Seconds() - Start;
+
+		Start = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumEvaluations; ++Index)
+		{
+			Sum += LUT.Eval(VelocityZ(Index));
+		}
+		const double LUTTime = FPlatformTime::Seconds() - Start;
+
+		float MaxError = 0.f;
+		for (int32 Index = 0; Index < NumEvaluations; Index += FMath::Max(NumEvaluations / 10000, 1))
+		{
+			MaxError = FMath::Max(MaxError, FMath::Abs(Curve->GetFloatValue(VelocityZ(Index)) - LUT.Eval(VelocityZ(Index))));
+		}
+
+		const double ToNanoseconds = 1000000000.0 / NumEvaluations;
+		UE_LOG(LogPredictedMovement, Display, TEXT("Curve %.2f ns, baked %.2f ns per evaluation, max error %f (checksum %f)"),
+			CurveTime * ToNanoseconds, LUTTime * ToNanoseconds, MaxError, Sum);
+
+		Curve->MarkAsGarbage();
+	}
+
+	/** Compares the bytes per move of the modifier stacks, with a byte per count and level, and bit-packed to the channel config */
+	static void BenchmarkModifierNetSerialize(const TArray<FString>& Args)
+	{
+		const UCustomMovementComponent* Defaults = GetDefault<UCustomMovementComponent>();
+		const int32 NumLevels = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 4, 1);
+		const FModifierStackNetFormat WantsFormat(CM_MAX_MODIFIER_STACK, NumLevels);
+		const FModifierStackNetFormat AppliedFormat(Defaults->bLimitMaxHastes ? Defaults->MaxHastes : CM_MAX_MODIFIER_STACK, NumLevels);
+
+		// The previous encoding, a byte for the count and a full level per element
+		const auto SerializeUnpacked = [](FArchive& Ar, const TModifierStack& Stack)
+		{
+			uint8 NumModifiers = static_cast<uint8>(Stack.Num());
+			Ar << NumModifiers;
+			for (TModSize Level : Stack)
+			{
+				Ar << Level;
+			}
+		};
+
+		// Each corrected channel (Haste, Slow, SlowFall) sends its wanted and applied modifiers with the move
+		constexpr int32 NumChannels = 3;
+		for (int32 NumModifiers = 1; NumModifiers <= 4; ++NumModifiers)
+		{
+			TModifierStack Stack;
+			for (int32 Index = 0; Index < NumModifiers; ++Index)
+			{
+				Stack.Add(static_cast<TModSize>(Index % NumLevels));
+			}
+
+			FBitWriter Unpacked(0, true);
+			FBitWriter Packed(0, true);
+			for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+			{
+				SerializeUnpacked(Unpacked, Stack);
+				SerializeUnpacked(Unpacked, Stack);
+				FModifierStatics::NetSerialize(Stack, Packed, TEXT("Benchmark"), WantsFormat);
+				FModifierStatics::NetSerialize(Stack, Packed, TEXT("Benchmark"), AppliedFormat);
+			}
+
+			UE_LOG(LogPredictedMovement, Display, TEXT("%d modifiers per channel, %d levels: %lld bits (%lld bytes) per move unpacked, %lld bits (%lld bytes) packed"),
+				NumModifiers, NumLevels, Unpacked.GetNumBits(), Unpacked.GetNumBytes(), Packed.GetNumBits(), Packed.GetNumBytes());
+		}
+	}
+
+	/** Compares processing the modifier channels through the process cache and through the full pipeline, while no modifier changes */
+	static void BenchmarkModifierProcess(const TArray<FString>& Args)
+	{
+		const int32 Iterations = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100000, 1);
+
+		// Channels like Haste, Slow and SlowFall, bound to local settings
+		TArray<FGameplayTag> LevelTags;
+		LevelTags.SetNum(4);
+		EModifierLevelMethod LevelMethod = EModifierLevelMethod::Max;
+		bool bLimitMaxModifiers = true;
+		int32 MaxModifiers = 8;
+
+		TModifierChannels<TModSize> Channels;
+		for (const TCHAR* Name : { TEXT("Haste"), TEXT("Slow"), TEXT("SlowFall") })
+		{
+			Channels.Register({ Name, &LevelTags, &LevelMethod, &bLimitMaxModifiers, &MaxModifiers, []() { return true; } });
+		}
+
+		for (int32 NumModifiers = 1; NumModifiers <= 8; NumModifiers *= 2)
+		{
+			for (int32 Channel = 0; Channel < Channels.Num(); ++Channel)
+			{
+				Channels.Correction[Channel].ResetModifiers();
+				Channels.Server[Channel].ResetModifiers();
+				for (int32 Index = 0; Index < NumModifiers; ++Index)
+				{
+					Channels.Correction[Channel].AddModifier(static_cast<TModSize>(Index % LevelTags.Num()));
+					Channels.Server[Channel].AddModifier(static_cast<TModSize>((Index + 1) % LevelTags.Num()));
+				}
+			}
+			Channels.Process();
+
+			// Every move processes the channels, almost always without any modifier having changed since the last one
+			int32 Checksum = 0;
+			double Start = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				Channels.Process();
+				Checksum += Channels.Levels[0];
+			}
+			const double CachedTime = FPlatformTime::Seconds() - Start;
+
+			Start = FPlatformTime::Seconds();
+			for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				Channels.InvalidateProcessCaches();
+				Channels.Process();
+				Checksum += Channels.Levels[0];
+			}
+			const double UncachedTime = FPlatformTime::Seconds() - Start;
+
+			const double ToNanoseconds = 1000000000.0 / Iterations;
+			UE_LOG(LogPredictedMovement, Display, TEXT("%d modifiers per stack, %d channels: cached %.2f ns, uncached %.2f ns per process (checksum %d)"),
+				NumModifiers, Channels.Num(), CachedTime * ToNanoseconds, UncachedTime * ToNanoseconds, Checksum);
+		}
+	}
+
+	/**
+	 * Compares reducing a stack of levels by switching on the level method for every reduction, as before the level kernels,
+	 * with the kernel resolved once through the stack and through its histogram
+	 */
+	static void BenchmarkLevelKernel(const TArray<FString>& Args)
+	{
+		const int32 Iterations = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100000, 1);
+		constexpr TModSize MaxLevel = 15;
+		constexpr TModSize None = TModifierLevelTraits<TModSize>::None;
+		constexpr EModifierLevelMethod Methods[] = { EModifierLevelMethod::Max, EModifierLevelMethod::Min, EModifierLevelMethod::Stack, EModifierLevelMethod::Average };
+
+		// The previous path, a switch on the method inside every reduction
+		const auto ReduceBySwitch = [](EModifierLevelMethod Method, TConstArrayView<TModSize> Levels, TModSize InMaxLevel) -> TModSize
+		{
+			if (Levels.IsEmpty())
+			{
+				return None;
+			}
+
+			uint32 Result = 0;
+			switch (Method)
+			{
+			case EModifierLevelMethod::Max:
+				Result = Levels[0];
+				for (const TModSize Level : Levels) { Result = FMath::Max<uint32>(Result, Level); }
+				break;
+			case EModifierLevelMethod::Min:
+				Result = Levels[0];
+				for (const TModSize Level : Levels) { Result = FMath::Min<uint32>(Result, Level); }
+				break;
+			case EModifierLevelMethod::Stack:
+				for (const TModSize Level : Levels) { Result += Level + 1; }
+				Result -= 1;
+				break;
+			case EModifierLevelMethod::Average:
+				for (const TModSize Level : Levels) { Result += Level; }
+				Result /= Levels.Num();
+				break;
+			default:
+				return None;
+			}
+			return static_cast<TModSize>(FMath::Min<uint32>(Result, InMaxLevel));
+		};
+
+		// The max level alternates so the reductions can't be hoisted out of the loops
+		const auto GetMaxLevel = [](int32 Iteration) { return static_cast<TModSize>(MaxLevel - (Iteration & 1)); };
+
+		for (const int32 NumLevels : { 1, 2, 4, 8, 16, 32, 64, 128, 254 })
+		{
+			TArray<TModSize> Levels;
+			FModifierLevelCounts Counts;
+			TModifierStack Stack;
+			for (int32 Index = 0; Index < NumLevels; ++Index)
+			{
+				const TModSize Level = static_cast<TModSize>((Index * 7) % (MaxLevel + 1));
+				Levels.Add(Level);
+				Counts.Add(Level);
+				Stack.Add(Level);
+			}
+
+			// Larger stacks only exist as histograms, the stack itself holds CM_MAX_MODIFIER_STACK levels
+			const bool bFitsStack = NumLevels <= TModifierStack::Max();
+
+			uint32 Checksum = 0;
+			double SwitchTime = 0.0;
+			double StackTime = 0.0;
+			double CountsTime = 0.0;
+			for (const EModifierLevelMethod Method : Methods)
+			{
+				double Start = FPlatformTime::Seconds();
+				for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+				{
+					Checksum += ReduceBySwitch(Method, Levels, GetMaxLevel(Iteration));
+				}
+				SwitchTime += FPlatformTime::Seconds() - Start;
+
+				const FModifierLevelKernel& Kernel = FModifierStatics::GetLevelKernel<TModSize>(Method);
+				if (bFitsStack)
+				{
+					Start = FPlatformTime::Seconds();
+					for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+					{
+						Checksum += Kernel.ReduceStack(Stack, GetMaxLevel(Iteration), None);
+					}
+					StackTime += FPlatformTime::Seconds() - Start;
+				}
+
+				Start = FPlatformTime::Seconds();
+				for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+				{
+					Checksum += Kernel.ReduceCounts(Counts, GetMaxLevel(Iteration), None);
+				}
+				CountsTime += FPlatformTime::Seconds() - Start;
+			}
+
+			const double ToNanoseconds = 1000000000.0 / (static_cast<double>(Iterations) * UE_ARRAY_COUNT(Methods));
+			if (bFitsStack)
+			{
+				UE_LOG(LogPredictedMovement, Display, TEXT("%3d levels: switch %.2f ns, kernel %.2f ns, kernel from histogram %.2f ns per reduction (checksum %u)"),
+					NumLevels, SwitchTime * ToNanoseconds, StackTime * ToNanoseconds, CountsTime * ToNanoseconds, Checksum);
+			}
+			else
+			{
+				UE_LOG(LogPredictedMovement, Display, TEXT("%3d levels: switch %.2f ns, kernel from histogram %.2f ns per reduction (checksum %u)"),
+					NumLevels, SwitchTime * ToNanoseconds, CountsTime * ToNanoseconds, Checksum);
+			}
+		}
+	}
+
+	FAutoConsoleCommand CmdBenchmarkCurveLUT(
+		TEXT("p.Modifiers.BenchmarkCurveLUT"),
+		TEXT("Times evaluating a gravity scalar curve directly and baked.\n")
+		TEXT("Optional argument: number of evaluations (default 1000000)"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkCurveLUT));
+
+	FAutoConsoleCommand CmdBenchmarkModifierBatch(
+		TEXT("p.Modifiers.BenchmarkBatch"),
+		TEXT("Times adding a Slow to 10, 100 and 1000 components individually and batched.\n")
+		TEXT("Optional argument: number of iterations (default 100)"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkModifierBatch));
+
+	FAutoConsoleCommand CmdBenchmarkModifierNetSerialize(
+		TEXT("p.Modifiers.BenchmarkNetSerialize"),
+		TEXT("Logs the bits per move of the modifier stacks with the previous byte encoding and bit-packed.\n")
+		TEXT("Optional argument: number of levels per channel (default 4)"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkModifierNetSerialize));
+
+	FAutoConsoleCommand CmdBenchmarkModifierProcess(
+		TEXT("p.Modifiers.BenchmarkProcess"),
+		TEXT("Times processing the modifier channels with and without the process cache, while no modifier changes.\n")
+		TEXT("Optional argument: number of iterations (default 100000)"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkModifierProcess));
+
+	FAutoConsoleCommand CmdBenchmarkLevelKernel(
+		TEXT("p.Modifiers.BenchmarkLevelKernel"),
+		TEXT("Times reducing stacks of 1 to 254 levels with a switch on the level method and with the level kernels.\n")
+		TEXT("Optional argument: number of iterations per method (default 100000)"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkLevelKernel));
+}
+
+#endif
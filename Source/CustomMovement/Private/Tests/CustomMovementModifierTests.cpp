@@ -0,0 +1,338 @@
+﻿#include "CustomMovementComponent.h"
+#include "CustomMovementTestCharacter.h"
+#include "HAL/MemoryBase.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace CustomMovementTests
+{
+	/** Ticks run before counting, so everything allocated on first use is in place */
+	constexpr int32 NumWarmUpTicks = 64;
+
+	/** Ticks counted once warmed up */
+	constexpr int32 NumSteadyStateTicks = 256;
+
+	constexpr float TickDeltaTime = 1.f / 60.f;
+
+	/** Bits reserved for a move or a response, well above what the modifiers of three channels take */
+	constexpr int64 MaxPacketBits = 8192;
+
+	/**
+	 * Forwards to the allocator it wraps, counting the allocations of the thread that installed it
+	 * Other threads keep allocating through it undisturbed, and may still hold it once uninstalled, so it is never destroyed
+	 */
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		static FCountingMalloc& Get()
+		{
+			static FCountingMalloc Instance;
+			return Instance;
+		}
+
+		/** Starts counting the calling thread's allocations */
+		void Install()
+		{
+			check(IsInGameThread() && GMalloc != this);
+			ThreadId = FPlatformTLS::GetCurrentThreadId();
+			NumAllocations = 0;
+			Inner = GMalloc;
+			GMalloc = this;
+		}
+
+		/** @return The number of allocations made since Install */
+		int32 Uninstall()
+		{
+			check(GMalloc == this);
+			GMalloc = Inner;
+			return NumAllocations;
+		}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation(Count);
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation(Count);
+			return Inner->TryMalloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation(Count);
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation(Count);
+			return Inner->TryRealloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override { Inner->Free(Original); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void UpdateStats() override { Inner->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+		virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+
+	private:
+		void CountAllocation(SIZE_T Size)
+		{
+			if (Size > 0 && FPlatformTLS::GetCurrentThreadId() == ThreadId)
+			{
+				NumAllocations++;
+			}
+		}
+
+		FMalloc* Inner = nullptr;
+		uint32 ThreadId = 0;
+		int32 NumAllocations = 0;
+	};
+
+	/**
+	 * The movement component of a character outside of any world
+	 * Enough for the modifier paths and the saved moves, which only need the owner's role and a movement mode the channels can activate in
+	 * PerformMovement returns without a world, the tests call the steps of a move that carry modifiers themselves
+	 */
+	UCustomMovementComponent* CreateMovementComponent(ENetRole Role = ROLE_Authority)
+	{
+		ACustomMovementTestCharacter* Character = NewObject<ACustomMovementTestCharacter>(GetTransientPackage());
+		Character->SetRole(Role);
+		UCustomMovementComponent* Movement = CastChecked<UCustomMovementComponent>(Character->GetCharacterMovement());
+		Movement->SetUpdatedComponent(Character->GetRootComponent());
+		Movement->MovementMode = MOVE_Walking;
+		Movement->EnsureModifierParams();
+		return Movement;
+	}
+
+	/**
+	 * Changes the modifiers of every channel the way gameplay does while moving, so every tick runs the full processing
+	 * pipeline rather than the process cache: a predicted modifier toggles, a timed server modifier is added and expires
+	 */
+	template<typename TLevel>
+	void ChurnModifiers(TModifierChannels<TLevel>& Channels, int32 Tick)
+	{
+		for (int32 Channel = 0; Channel < Channels.Num(); ++Channel)
+		{
+			const int32 NumLevels = Channels.Configs[Channel].LevelTags->Num();
+			if (NumLevels == 0)
+			{
+				continue;
+			}
+
+			const TLevel Level = static_cast<TLevel>((Tick / 2 + Channel) % NumLevels);
+			if (Tick % 2 == 0)
+			{
+				Channels.Correction[Channel].AddModifier(Level);
+			}
+			else
+			{
+				Channels.Correction[Channel].RemoveModifier(Level, false);
+			}
+
+			if (Tick % 8 == Channel && Channels.AddServerModifier(Channel, Level))
+			{
+				Channels.Timers.Add(Channel, Level, true, 4.f * TickDeltaTime);
+			}
+		}
+	}
+}
+
+using namespace CustomMovementTests;
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FModifierProcessAllocationTest, "CustomMovement.Modifiers.ProcessDoesNotAllocate",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FModifierProcessAllocationTest::RunTest(const FString& Parameters)
+{
+	UCustomMovementComponent* Movement = CreateMovementComponent();
+
+	const auto Tick = [Movement](int32 Index)
+	{
+		ForEachModifierWidth([Movement, Index](auto& Channels)
+		{
+			ChurnModifiers(Channels, Index);
+			Channels.AdvanceTimers(Index * TickDeltaTime, Movement->MinTimeBetweenTimeStampResets);
+		}, Movement->ModifierChannels);
+		Movement->ProcessModifierMovementState();
+	};
+
+	for (int32 Index = 0; Index < NumWarmUpTicks; ++Index)
+	{
+		Tick(Index);
+	}
+
+	FCountingMalloc::Get().Install();
+	for (int32 Index = NumWarmUpTicks; Index < NumWarmUpTicks + NumSteadyStateTicks; ++Index)
+	{
+		Tick(Index);
+	}
+	const int32 NumAllocations = FCountingMalloc::Get().Uninstall();
+
+	TestEqual(FString::Printf(TEXT("Heap allocations over %d warmed up modifier ticks"), NumSteadyStateTicks), NumAllocations, 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FModifierMoveAllocationTest, "CustomMovement.Modifiers.MoveDoesNotAllocate",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+/**
+ * The modifier work of a predicted move, end to end, through the component's saved moves, move data and responses: the client saves
+ * and sends the move along with the previous one, the server performs it and responds, the client applies the response
+ * Stacks, saved moves, move data and responses are inline, so once warmed up none of it allocates
+ */
+bool FModifierMoveAllocationTest::RunTest(const FString& Parameters)
+{
+	UCustomMovementComponent* ClientMovement = CreateMovementComponent(ROLE_AutonomousProxy);
+	UCustomMovementComponent* ServerMovement = CreateMovementComponent();
+	ACharacter* ClientCharacter = ClientMovement->GetCharacterOwner();
+
+	// The registry of the level width of the built-in channels
+	using FLevel = FHasteLevel;
+	TModifierChannels<FLevel>& Client = ClientMovement->ModifierChannels.Get<FLevel>();
+	TModifierChannels<FLevel>& Server = ServerMovement->ModifierChannels.Get<FLevel>();
+
+	// Saved moves come from the client's network prediction data, which pools them
+	FNetworkPredictionData_Client_Character* ClientData = ClientMovement->GetPredictionData_Client_Character();
+	TArray<FSavedMovePtr, TInlineAllocator<4>> SavedMoves;
+	for (int32 Index = 0; Index < 4; ++Index)
+	{
+		SavedMoves.Add(ClientData->CreateSavedMove());
+	}
+
+	FCharacterNetworkMoveDataContainer& ClientMoveData = ClientMovement->GetNetworkMoveDataContainer();
+	FCharacterNetworkMoveDataContainer& ServerMoveData = ServerMovement->GetNetworkMoveDataContainer();
+	FPredictedMoveResponseDataContainer& ServerResponse = static_cast<FPredictedMoveResponseDataContainer&>(ServerMovement->GetMoveResponseDataContainer());
+	FPredictedMoveResponseDataContainer& ClientResponse = static_cast<FPredictedMoveResponseDataContainer&>(ClientMovement->GetMoveResponseDataContainer());
+
+	// Packets are written to and read from buffers reserved up front, as the net driver does
+	FBitWriter Writer(MaxPacketBits, false);
+	FBitWriterMark WriterStart(Writer);
+	FBitReader Reader(Writer.GetData(), MaxPacketBits);
+	FBitReaderMark ReaderStart(Reader);
+
+	const auto SendPacket = [&Writer, &WriterStart, &Reader, &ReaderStart]()
+	{
+		FMemory::Memcpy(Reader.GetData(), Writer.GetData(), Writer.GetNumBytes());
+		ReaderStart.Pop(Reader);
+		WriterStart.Pop(Writer);
+	};
+
+	bool bSerialized = true;
+	const auto Move = [&](int32 Index)
+	{
+		const float TimeStamp = (Index + 1) * TickDeltaTime;
+		ClientData->CurrentTimeStamp = TimeStamp;
+
+		// Client, changes its modifiers the way input does, then predicts the move and saves it
+		for (int32 Channel = 0; Channel < Client.Num(); ++Channel)
+		{
+			const FLevel Level = static_cast<FLevel>((Index / 2 + Channel) % Client.Configs[Channel].LevelTags->Num());
+			if (Index % 2 == 0)
+			{
+				Client.Local[Channel].AddModifier(Level);
+				Client.Correction[Channel].AddModifier(Level);
+			}
+			else
+			{
+				Client.Local[Channel].RemoveModifier(Level, false);
+				Client.Correction[Channel].RemoveModifier(Level, false);
+			}
+		}
+		// Stamina changes every move, on the server too, except where it drifts enough to be corrected
+		const float Stamina = ClientMovement->GetMaxStamina() * (Index % 10) / 10.f;
+		ClientMovement->SetStamina(Stamina);
+
+		FSavedMove_Character& SavedMove = *SavedMoves[Index % SavedMoves.Num()];
+		const FSavedMove_Character* PendingMove = Index > 0 ? SavedMoves[(Index - 1) % SavedMoves.Num()].Get() : nullptr;
+		SavedMove.Clear();
+		SavedMove.SetMoveFor(ClientCharacter, TickDeltaTime, FVector::ZeroVector, *ClientData);
+		ClientMovement->UpdateCharacterStateBeforeMovement(TickDeltaTime);
+		ClientMovement->UpdateCharacterStateAfterMovement(TickDeltaTime);
+		SavedMove.PostUpdate(ClientCharacter, FSavedMove_Character::PostUpdate_Record);
+
+		// Client, sends the move with the previous one as a pending move, which mostly serializes as the same as the new move
+		ClientMoveData.ClientFillNetworkMoveData(&SavedMove, PendingMove, nullptr);
+		bSerialized &= ClientMoveData.Serialize(*ClientMovement, Writer, nullptr);
+		SendPacket();
+		bSerialized &= ServerMoveData.Serialize(*ServerMovement, Reader, nullptr);
+
+		// Server, performs the move as ServerMove_PerformMovement, MoveAutonomous and ServerMoveHandleClientError do
+		const FPredictedNetworkMoveData& MoveData = static_cast<const FPredictedNetworkMoveData&>(*ServerMoveData.GetNewMoveData());
+		Server.ServerMove_PerformMovement(MoveData.ModifierChannels.Get<FLevel>());
+		ServerMovement->SetStamina(Index % 16 == 8 ? Stamina + 2.f * ServerMovement->NetworkStaminaCorrectionThreshold : Stamina);
+		ServerMovement->UpdateCharacterStateBeforeMovement(TickDeltaTime);
+		ServerMovement->UpdateCharacterStateAfterMovement(TickDeltaTime);
+		const bool bClientError = Server.ServerCheckClientError(MoveData.ModifierChannels.Get<FLevel>())
+			|| !FMath::IsNearlyEqual(MoveData.Stamina, ServerMovement->QuantizeNetworkStamina(ServerMovement->GetStamina()), ServerMovement->NetworkStaminaCorrectionThreshold);
+		Server.ServerCacheClientModifiers(MoveData.ModifierChannels.Get<FLevel>(), MoveData.TimeStamp);
+
+		// Server, changes its own modifiers the way gameplay does
+		const int32 Channel = Index % Server.Num();
+		const FLevel Level = static_cast<FLevel>(Index % Server.Configs[Channel].LevelTags->Num());
+		if (Index % 8 == 0 && Server.AddServerModifier(Channel, Level))
+		{
+			Server.Timers.Add(Channel, Level, true, 4.f * TickDeltaTime);
+		}
+		if (Index % 16 == 4)
+		{
+			Server.AddScheduledModifier(Channel, EModifierOp::Add, Level, TimeStamp + 4.f * TickDeltaTime);
+		}
+		else if (Index % 16 == 12)
+		{
+			Server.AddScheduledModifier(Channel, EModifierOp::Reset, Level, TimeStamp + 4.f * TickDeltaTime);
+		}
+
+		// Server, acks the move or corrects the client
+		FClientAdjustment Adjustment;
+		Adjustment.TimeStamp = MoveData.TimeStamp;
+		Adjustment.DeltaTime = TickDeltaTime;
+		Adjustment.MovementMode = ServerMovement->PackNetworkMovementMode();
+		Adjustment.bAckGoodMove = !bClientError;
+		ServerResponse.ServerFillResponseData(*ServerMovement, Adjustment);
+		bSerialized &= ServerResponse.Serialize(*ServerMovement, Writer, nullptr);
+		SendPacket();
+		bSerialized &= ClientResponse.Serialize(*ClientMovement, Reader, nullptr);
+
+		// Client, applies the response, corrections as OnClientCorrectionReceived does since adjusting the position needs a world
+		ClientMovement->ClientHandleMoveResponse(ClientResponse);
+		if (!ClientResponse.IsGoodMove())
+		{
+			ClientMovement->SetStamina(ClientResponse.Stamina);
+			ClientMovement->SetStaminaDrained(ClientResponse.bStaminaDrained);
+			Client.OnClientCorrectionReceived(ClientResponse.ModifierChannels.Get<FLevel>(),
+				&static_cast<const FPredictedSavedMove&>(SavedMove).ModifierChannels.Get<FLevel>());
+		}
+	};
+
+	for (int32 Index = 0; Index < NumWarmUpTicks; ++Index)
+	{
+		Move(Index);
+	}
+
+	FCountingMalloc::Get().Install();
+	for (int32 Index = NumWarmUpTicks; Index < NumWarmUpTicks + NumSteadyStateTicks; ++Index)
+	{
+		Move(Index);
+	}
+	const int32 NumAllocations = FCountingMalloc::Get().Uninstall();
+
+	TestTrue(TEXT("Modifier moves and responses serialized"), bSerialized);
+	TestEqual(FString::Printf(TEXT("Heap allocations over %d warmed up predicted moves"), NumSteadyStateTicks), NumAllocations, 0);
+	return true;
+}
+
+#endif
@@ -0,0 +1,23 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Character.h"
+
+#include "CustomMovementComponent.h"
+
+#include "CustomMovementTestCharacter.generated.h"
+
+/**
+ * A character moved by UCustomMovementComponent, for automation tests that drive its saved moves and move data outside of a world
+ * The saved moves and move data reach the component through the character, so it must be the character's own movement component
+ */
+UCLASS(Transient, NotPlaceable, NotBlueprintable, HideDropdown)
+class ACustomMovementTestCharacter : public ACharacter
+{
+	GENERATED_BODY()
+
+public:
+	ACustomMovementTestCharacter(const FObjectInitializer& ObjectInitializer)
+		: Super(ObjectInitializer.SetDefaultSubobjectClass<UCustomMovementComponent>(CharacterMovementComponentName))
+	{}
+};
@@ -1,19 +1,37 @@
 ﻿#pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/Queue.h"
 #include "GameFramework/CharacterMovementComponent.h"
 
 #include "CustomMovementTypes.h"
 #include "Modifier/ModifierTypes.h"
 #include "Modifier/ModifierImpl.h"
+#include "Modifier/ModifierChannels.h"
 
 #include "CustomMovementComponent.generated.h"
 
 //class FPredictedSavedMove;
+struct FOverlapResult;
+class UAbilitySystemComponent;
 
-using TMod_Local = FMovementModifier_LocalPredicted;
-using TMod_LocalCorrection = FMovementModifier_WithCorrection;
-using TMod_Server = FMovementModifier_WithCorrection;
+template<typename TLevel>
+using TMod_Local = TMovementModifier_LocalPredicted<TLevel>;
+
+template<typename TLevel>
+using TMod_LocalCorrection = TMovementModifier_WithCorrection<TLevel>;
+
+template<typename TLevel>
+using TMod_Server = TMovementModifier_ServerInitiated<TLevel>;
+
+/**
+ * Level width of each modifier type, uint8 or uint16
+ * Change a type to uint16 if it needs more than 254 levels, it is then registered with the uint16 channels
+ * and its stacks, moves and corrections follow without affecting the others
+ */
+using FHasteLevel = uint8;
+using FSlowLevel = uint8;
+using FSlowFallLevel = uint8;
 
 struct CUSTOMMOVEMENT_API FPredictedMoveResponseDataContainer : FCharacterMoveResponseDataContainer
 {
@@ -24,13 +42,10 @@ struct CUSTOMMOVEMENT_API FPredictedMoveResponseDataContainer : FCharacterMoveRe
 	bool bStaminaDrained;
 
 	/*
-	 * Used by the server to send Modifier data to the client
+	 * Used by the server to send Modifier data to the client, for every modifier channel
 	 * LocalPredicted modifiers are not sent, as the server does not correct input states
 	 */
-	
-	FModifierMoveResponse HasteCorrection;		// Haste
-	FModifierMoveResponse SlowCorrection; 		// Slow
-	FModifierMoveResponse SlowFallCorrection; 	// SlowFall
+	TModifierWidths<TModifierResponseChannels> ModifierChannels;
 
 	/** Tell the client how much location authority they have */
 		float ClientAuthAlpha = 0.f;
@@ -61,17 +76,11 @@ struct FPredictedNetworkMoveData : public FCharacterNetworkMoveData
 	float Stamina;
 
 	/*
-	 * Used by the client to send Modifier data to the server
+	 * Used by the client to send Modifier data to the server, for every modifier channel
 	 * If local predicted, this data is based on player input, and the server will apply it
 	 * Otherwise, the server will compare the client and server data to know when to send a correction
 	 */
-	
-	FModifierMoveData_LocalPredicted HasteLocal; 			// Haste
-	FModifierMoveData_WithCorrection HasteCorrection; 		// Haste
-	FModifierMoveData_LocalPredicted SlowLocal; 			// Slow
-	FModifierMoveData_WithCorrection SlowCorrection;		// Slow
-	FModifierMoveData_LocalPredicted SlowFallLocal; 		// SlowFall
-	FModifierMoveData_WithCorrection SlowFallCorrection;	// SlowFall
+	TModifierWidths<TModifierMoveDataChannels> ModifierChannels;
 
 	virtual void ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType) override;
 	virtual bool Serialize(UCharacterMovementComponent& Movement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType) override;
@@ -92,6 +101,47 @@ private:
 	FPredictedNetworkMoveData MoveData[3];
 };
 
+/**
+ * Movement attributes resolved once per move, so the final movement getters don't re-walk the gait, stamina and modifier
+ * scalar chain every time CalcVelocity, PhysWalking, etc. query them
+ * The attributes are only used while the state they were resolved from is unchanged, a mid-move gait, stance, movement
+ * mode or modifier change falls back to resolving live
+ * Anything that depends on velocity (sprinting in effect, SlowFall gravity curves) is always resolved live
+ * @see UCustomMovementComponent::ResolveMovementAttributes
+ */
+struct CUSTOMMOVEMENT_API FResolvedMovementAttributes
+{
+	/* State the attributes were resolved from */
+
+	TEnumAsByte<EMovementMode> MovementMode = MOVE_None;
+	uint8 CustomMovementMode = 0;
+	bool bCrouched = false;
+	bool bSprinting = false;
+	bool bWalking = false;
+	bool bStaminaDrained = false;
+	TModifierWidths<TModifierChannelArray> ModifierLevels;
+
+	/* Resolved attributes */
+
+	ECustomMovementGaitMode GaitMode = ECustomMovementGaitMode::Run;
+	float GaitSpeedFactor = 1.f;
+	float BaseMaxSpeed = 0.f;
+	float BaseMaxBrakingDeceleration = 0.f;
+	float BaseBrakingFriction = 0.f;
+	float MaxAccelerationScalar = 1.f;
+	float MaxSpeedScalar = 1.f;
+	float MaxBrakingDecelerationScalar = 1.f;
+	float GroundFrictionScalar = 1.f;
+	float BrakingFrictionScalar = 1.f;
+	float RootMotionTranslationScalar = 1.f;
+	float GravityZScalar = 1.f;
+
+	/** GravityZScalar is scaled by a curve sampled from velocity, so it can't be resolved ahead of the move */
+	bool bGravityZScalarFromVelocity = false;
+
+	bool bValid = false;
+};
+
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class CUSTOMMOVEMENT_API UCustomMovementComponent : public UCharacterMovementComponent
 {
@@ -271,6 +321,26 @@ public:
 	/** Maximum stamina difference that is allowed between client and server before a correction occurs. */
 	UPROPERTY(Category="Character Movement (Networking)", EditDefaultsOnly, meta=(ClampMin="0.0", UIMin="0.0"))
 	float NetworkStaminaCorrectionThreshold;
+
+	/**
+	 * Minimum bits stamina is sent with, over [0, BaseMaxStamina] of the archetype
+	 * Raised when a step would exceed half of NetworkStaminaCorrectionThreshold, so quantization alone never causes a correction
+	 * Up to 16 bits, a threshold below two steps of that is only honored as closely as 16 bits allow
+	 * Stamina above the range is sent at the same step with a few extra bytes, MaxStamina may change at runtime on either end
+	 */
+	UPROPERTY(Category="Character Movement (Networking)", EditDefaultsOnly, meta=(ClampMin="1", UIMin="1", ClampMax="16", UIMax="16"))
+	int32 NetworkStaminaBits;
+
+	/**
+	 * Added to the client's round trip time when scheduling a modifier, to absorb jitter
+	 * The client must receive the schedule before it simulates the scheduled move, otherwise it is corrected
+	 */
+	UPROPERTY(Category="Character Movement (Networking)", EditDefaultsOnly, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="s"))
+	float ScheduledModifierLeadMargin;
+
+	/** Scheduled modifiers never apply later than this after being scheduled, clients with higher latency are corrected instead */
+	UPROPERTY(Category="Character Movement (Networking)", EditDefaultsOnly, meta=(ClampMin="0.0", UIMin="0.0", ForceUnits="s"))
+	float MaxScheduledModifierLead;
 	
 protected:
 	/** THIS SHOULD ONLY BE MODIFIED IN DERIVED CLASSES FROM OnStaminaChanged AND NOWHERE ELSE */
@@ -295,7 +365,7 @@ public:
 	/**
 	 * Limits the maximum number of Haste levels that can be applied to the character
 	 * This value is shared between each type of Haste
-	 * It limits both the number being serialized and sent over the network, as well as having gameplay implications
+	 * It limits both the number being serialized and sent over the network (by its class default value), as well as having gameplay implications
 	 * Priority is granted in order, because modifiers consume the remaining slots, so LocalPredicted -> WithCorrection - ServerInitiated
 	 */
 	UPROPERTY(Category="Character Movement: Modifiers", EditAnywhere, BlueprintReadWrite, meta=(InlineEditConditionToggle))
@@ -304,10 +374,10 @@ public:
 	/**
 	 * Maximum number of Haste levels that can be applied to the character
 	 * This value is shared between each type of Haste
-	 * It limits both the number being serialized and sent over the network, as well as having gameplay implications
+	 * It limits both the number being serialized and sent over the network (by its class default value), as well as having gameplay implications
 	 * Priority is granted in order, because modifiers consume the remaining slots, so LocalPredicted -> WithCorrection - ServerInitiated
 	 */
-	UPROPERTY(Category="Character Movement: Modifiers", EditAnywhere, BlueprintReadWrite, meta=(ClampMin=1, UIMin=1, UIMax=32, EditCondition="bLimitMaxHastes"))
+	UPROPERTY(Category="Character Movement: Modifiers", EditAnywhere, BlueprintReadWrite, meta=(ClampMin=1, UIMin=1, ClampMax=32, UIMax=32, EditCondition="bLimitMaxHastes"))
 	int32 MaxHastes = 8;
 
 	/** Indexed list of Haste levels, used to determine the current Haste level based on index */
@@ -318,11 +388,11 @@ public:
 	UPROPERTY(Category="Character Movement: Modifiers", EditAnywhere, BlueprintReadWrite)
 	EModifierLevelMethod HasteLevelMethod;
 	
-	/** Local Predicted Haste based on Player Input */
-	TMod_Local HasteLocal;
+	/** Level of each tag in HasteLevels */
+	TModifierLevelIndex<FHasteLevel> HasteLevelIndex;
 
-	/** Local Predicted Haste based on Player Input, that can be corrected by the server when a mismatch occurs */
-	TMod_LocalCorrection HasteCorrection;
+	/** Haste params indexed by level, aligned with HasteLevels */
+	TModifierParamsTable<FMovementModifierParams> HasteParamsTable;
 	
 public:
 	/**
@@ -335,7 +405,7 @@ public:
 	/**
 	 * Limits the maximum number of Slow levels that can be applied to the character
 	 * This value is shared between each type of Slow
-	 * It limits both the number being serialized and sent over the network, as well as having gameplay implications
+	 * It limits both the number being serialized and sent over the network (by its class default value), as well as having gameplay implications
 	 * Priority is granted in order, because modifiers consume the remaining slots, so LocalPredicted -> WithCorrection - ServerInitiated
 	 */
 	UPROPERTY(Category="Character Movement: Modifiers", EditAnywhere, BlueprintReadWrite, meta=(InlineEditConditionToggle))
@@ -344,10 +414,10 @@ public:
 	/**
 	 * Maximum number of Slow levels that can be applied to the character
 	 * This value is shared between each type of Slow
-	 * It limits both the number being serialized and sent over the network, as well as having gameplay implications
+	 * It limits both the number being serialized and sent over the network (by its class default value), as well as having gameplay implications
 	 * Priority is granted in order, because modifiers consume the remaining slots, so LocalPredicted -> WithCorrection - ServerInitiated
 	 */
-	UPROPERTY(Category="Character Movement: Modifiers", EditAnywhere, BlueprintReadWrite, meta=(ClampMin=1, UIMin=1, UIMax=32, EditCondition="bLimitMaxSlows"))
+	UPROPERTY(Category="Character Movement: Modifiers", EditAnywhere, BlueprintReadWrite, meta=(ClampMin=1, UIMin=1, ClampMax=32, UIMax=32, EditCondition="bLimitMaxSlows"))
 	int32 MaxSlows = 8;
 	
 	/** Indexed list of Slow levels, used to determine the current Slow level based on index */
@@ -358,11 +428,11 @@ public:
 	UPROPERTY(Category="Character Movement: Modifiers", EditAnywhere, BlueprintReadWrite)
 	EModifierLevelMethod SlowLevelMethod;
 	
-	/** Local Predicted Slow based on Player Input */
-	TMod_Local SlowLocal;
+	/** Level of each tag in SlowLevels */
+	TModifierLevelIndex<FSlowLevel> SlowLevelIndex;
 
-	/** Local Predicted Slow based on Player Input, that can be corrected by the server when a mismatch occurs */
-	TMod_LocalCorrection SlowCorrection;
+	/** Slow params indexed by level, aligned with SlowLevels */
+	TModifierParamsTable<FMovementModifierParams> SlowParamsTable;
 	
 public:
 	/**
@@ -375,7 +445,7 @@ public:
 	/**
 	 * Limits the maximum number of SlowFall levels that can be applied to the character
 	 * This value is shared between each type of SlowFall
-	 * It limits both the number being serialized and sent over the network, as well as having gameplay implications
+	 * It limits both the number being serialized and sent over the network (by its class default value), as well as having gameplay implications
 	 * Priority is granted in order, because modifiers consume the remaining slots, so LocalPredicted -> WithCorrection - ServerInitiated
 	 */
 	UPROPERTY(Category="Character Movement: Modifiers", EditAnywhere, BlueprintReadWrite, meta=(InlineEditConditionToggle))
@@ -384,10 +454,10 @@ public:
 	/**
 	 * Maximum number of SlowFall levels that can be applied to the character
 	 * This value is shared between each type of SlowFall
-	 * It limits both the number being serialized and sent over the network, as well as having gameplay implications
+	 * It limits both the number being serialized and sent over the network (by its class default value), as well as having gameplay implications
 	 * Priority is granted in order, because modifiers consume the remaining slots, so LocalPredicted -> WithCorrection - ServerInitiated
 	 */
-	UPROPERTY(Category="Character Movement: Modifiers", EditAnywhere, BlueprintReadWrite, meta=(ClampMin=1, UIMin=1, UIMax=32, EditCondition="bLimitMaxSlowFalls"))
+	UPROPERTY(Category="Character Movement: Modifiers", EditAnywhere, BlueprintReadWrite, meta=(ClampMin=1, UIMin=1, ClampMax=32, UIMax=32, EditCondition="bLimitMaxSlowFalls"))
 	int32 MaxSlowFalls = 8;
 	
 	/** Indexed list of SlowFall levels, used to determine the current SlowFall level */
@@ -398,11 +468,20 @@ public:
 	UPROPERTY(Category="Character Movement: Modifiers", EditAnywhere, BlueprintReadWrite)
 	EModifierLevelMethod SlowFallLevelMethod;
 
-	/** Local Predicted SlowFall based on Player Input */
-	TMod_Local SlowFallLocal;
+	/** Level of each tag in SlowFallLevels */
+	TModifierLevelIndex<FSlowFallLevel> SlowFallLevelIndex;
 
-	/** Local Predicted SlowFall based on Player Input, that can be corrected by the server when a mismatch occurs */
-	TMod_LocalCorrection SlowFallCorrection;
+	/** SlowFall params indexed by level, aligned with SlowFallLevels */
+	TModifierParamsTable<FFallingModifierParams> SlowFallParamsTable;
+
+public:
+	/**
+	 * Modifiers applied while the owner's ability system has a tag, instead of polling the tags to set and clear them
+	 * Bound to tag events from BeginPlay, so the modifiers only change when the tags do
+	 * @see BindModifierTags
+	 */
+	UPROPERTY(Category="Character Movement: Modifiers", EditAnywhere, BlueprintReadOnly)
+	TArray<FModifierTagBinding> ModifierTagBindings;
 
 public:
 	/** Client auth parameters mapped to a source gameplay tag */
@@ -425,7 +504,10 @@ public:
 	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif
 	
+	virtual void PostLoad() override;
+	virtual void OnRegister() override;
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	
 public:
 	UFUNCTION(BlueprintPure)
@@ -465,17 +547,38 @@ public:
 
 	// Final movement values
 	
-	virtual float GetMaxAcceleration() const override { return GetBaseMaxAcceleration() * GetMaxAccelerationScalar(); }
-	virtual float GetMaxSpeed() const override { return GetBaseMaxSpeed() * GetMaxSpeedScalar(); }
-	virtual float GetMaxBrakingDeceleration() const override { return GetBaseMaxBrakingDeceleration() * GetMaxBrakingDecelerationScalar(); }
-	virtual float GetGroundFriction(float DefaultGroundFriction) const { return GetBaseGroundFriction(DefaultGroundFriction) * GetGroundFrictionScalar(); }
-	virtual float GetBrakingFriction() const { return GetBaseBrakingFriction() * GetBrakingFrictionScalar(); }
+	virtual float GetMaxAcceleration() const override;
+	virtual float GetMaxSpeed() const override;
+	virtual float GetMaxBrakingDeceleration() const override;
+	virtual float GetGroundFriction(float DefaultGroundFriction) const;
+	virtual float GetBrakingFriction() const;
 
 	// Falling
 	
 	virtual float GetGravityZ() const override;
 	virtual FVector GetAirControl(float DeltaTime, float TickAirControl, const FVector& FallAcceleration) override;
 
+public:
+	// Resolved movement attributes
+
+	/**
+	 * Resolves the gait, base values and scalars for the current move, called at the end of UpdateCharacterStateBeforeMovement
+	 * Override to resolve additional attributes, the scalar and base value virtuals are honored as-is
+	 */
+	virtual void ResolveMovementAttributes();
+
+	/** Discards the resolved attributes, call after changing speeds or scalars mid-move so the getters resolve live */
+	void InvalidateMovementAttributes() { ResolvedAttributes.bValid = false; }
+
+	/** The attributes resolved for the current move, or nullptr if they no longer match the current state */
+	const FResolvedMovementAttributes* GetResolvedMovementAttributes() const;
+
+	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+
+protected:
+	/** Attributes resolved for the current move */
+	FResolvedMovementAttributes ResolvedAttributes;
+
 public:	
 	virtual void CalcStamina(float DeltaTime);
 	virtual void CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration) override;
@@ -543,6 +646,18 @@ public:
 	void SetStamina(float NewStamina);
 	void SetMaxStamina(float NewMaxStamina);
 	void SetStaminaDrained(bool bNewValue);
+
+	/**
+	 * Bits stamina is sent with, NetworkStaminaBits raised to keep a step within half of NetworkStaminaCorrectionThreshold
+	 * Read from the archetype, never the live MaxStamina, so client and server agree on the wire format
+	 */
+	int32 GetNetworkStaminaBits() const;
+
+	/** Stamina per step on the wire, from the archetype like GetNetworkStaminaBits, 0 to send it unquantized */
+	float GetNetworkStaminaStep() const;
+
+	/** Rounds stamina to the precision it is sent with, client and server compare quantized values */
+	float QuantizeNetworkStamina(float Value) const;
 	
 protected:
 	/*
@@ -558,80 +673,320 @@ protected:
 public:
 	/* Haste Implementation */
 
-	uint8 HasteLevel = NO_MODIFIER;
+	/** Current level of Haste, None if inactive */
+	FHasteLevel GetCurrentHasteLevel() const { return ModifierChannels.Get<FHasteLevel>().Levels[HasteChannel.Index]; }
 
 	UFUNCTION(BlueprintCallable, Category="Custom Character Movement")
-	bool IsHasteActive() const { return HasteLevel != NO_MODIFIER; }
-	const FMovementModifierParams* GetHasteParams() const { return Haste.Find(GetHasteLevel()); }
-	FGameplayTag GetHasteLevel() const { return HasteLevels.IsValidIndex(HasteLevel) ? HasteLevels[HasteLevel] : FGameplayTag::EmptyTag; }
-	uint8 GetHasteLevelIndex(const FGameplayTag& Level) const { return HasteLevels.IndexOfByKey(Level) > INDEX_NONE ? HasteLevels.IndexOfByKey(Level) : NO_MODIFIER; }
+	bool IsHasteActive() const { return GetCurrentHasteLevel() != TModifierLevelTraits<FHasteLevel>::None; }
+	const FMovementModifierParams* GetHasteParams() const { return HasteParamsTable.Find(GetCurrentHasteLevel()); }
+	FGameplayTag GetHasteLevel() const { const FHasteLevel Level = GetCurrentHasteLevel(); return HasteLevels.IsValidIndex(Level) ? HasteLevels[Level] : FGameplayTag::EmptyTag; }
+	FHasteLevel GetHasteLevelIndex(const FGameplayTag& Level) const { return HasteLevelIndex.Find(Level); }
 	virtual bool CanHasteInCurrentState() const;
 
-	float GetHasteSpeedScalar() const { return GetHasteParams() ? GetHasteParams()->MaxWalkSpeed : 1.f; }
-	float GetHasteAccelScalar() const { return GetHasteParams() ? GetHasteParams()->MaxAcceleration : 1.f; }
-	float GetHasteBrakingScalar() const { return GetHasteParams() ? GetHasteParams()->BrakingDeceleration : 1.f; }
-	float GetHasteGroundFrictionScalar() const { return GetHasteParams() ? GetHasteParams()->GroundFriction : 1.f; }
-	float GetHasteBrakingFrictionScalar() const { return GetHasteParams() ? GetHasteParams()->BrakingFriction : 1.f; }
-	bool HasteAffectsRootMotion() const { return GetHasteParams() ? GetHasteParams()->bAffectsRootMotion : false; }
+	float GetHasteSpeedScalar() const { const FMovementModifierParams* Params = GetHasteParams(); return Params ? Params->MaxWalkSpeed : 1.f; }
+	float GetHasteAccelScalar() const { const FMovementModifierParams* Params = GetHasteParams(); return Params ? Params->MaxAcceleration : 1.f; }
+	float GetHasteBrakingScalar() const { const FMovementModifierParams* Params = GetHasteParams(); return Params ? Params->BrakingDeceleration : 1.f; }
+	float GetHasteGroundFrictionScalar() const { const FMovementModifierParams* Params = GetHasteParams(); return Params ? Params->GroundFriction : 1.f; }
+	float GetHasteBrakingFrictionScalar() const { const FMovementModifierParams* Params = GetHasteParams(); return Params ? Params->BrakingFriction : 1.f; }
+	bool HasteAffectsRootMotion() const { const FMovementModifierParams* Params = GetHasteParams(); return Params ? Params->bAffectsRootMotion : false; }
 	
+	/**
+	 * @param bServerInitiated Apply on the server only and push to the client, instead of predicting it locally
+	 * @param Duration Seconds of movement simulation before the modifier is removed, 0 to keep it until cleared
+	 */
 	UFUNCTION(BlueprintCallable, Category="Custom Character Movement")
-	void SetHasteByTag(const FGameplayTag Tag);
+	void SetHasteByTag(const FGameplayTag Tag, bool bServerInitiated = false, float Duration = 0.f);
+
+	/** @see ScheduleChannelModifier */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category="Custom Character Movement")
+	void ScheduleHasteByTag(const FGameplayTag Tag, float Duration = 0.f);
 	
 	UFUNCTION(BlueprintCallable, Category="Custom Character Movement")
-	void ClearHaste();
+	void ClearHaste(bool bServerInitiated = false);
 
 	/* ~Haste Implementation */
 
 public:
 	/* Slow Implementation */
 	
-	uint8 SlowLevel = NO_MODIFIER;
+	/** Current level of Slow, None if inactive */
+	FSlowLevel GetCurrentSlowLevel() const { return ModifierChannels.Get<FSlowLevel>().Levels[SlowChannel.Index]; }
 
 	UFUNCTION(BlueprintCallable, Category="Custom Character Movement")
-	bool IsSlowActive() const { return SlowLevel != NO_MODIFIER; }
-	const FMovementModifierParams* GetSlowParams() const { return Slow.Find(GetSlowLevel()); }
-	FGameplayTag GetSlowLevel() const { return SlowLevels.IsValidIndex(SlowLevel) ? SlowLevels[SlowLevel] : FGameplayTag::EmptyTag; }
-	uint8 GetSlowLevelIndex(const FGameplayTag& Level) const { return SlowLevels.IndexOfByKey(Level) > INDEX_NONE ? SlowLevels.IndexOfByKey(Level) : NO_MODIFIER; }
+	bool IsSlowActive() const { return GetCurrentSlowLevel() != TModifierLevelTraits<FSlowLevel>::None; }
+	const FMovementModifierParams* GetSlowParams() const { return SlowParamsTable.Find(GetCurrentSlowLevel()); }
+	FGameplayTag GetSlowLevel() const { const FSlowLevel Level = GetCurrentSlowLevel(); return SlowLevels.IsValidIndex(Level) ? SlowLevels[Level] : FGameplayTag::EmptyTag; }
+	FSlowLevel GetSlowLevelIndex(const FGameplayTag& Level) const { return SlowLevelIndex.Find(Level); }
 	virtual bool CanSlowInCurrentState() const;
 
-	float GetSlowSpeedScalar() const { return GetSlowParams() ? GetSlowParams()->MaxWalkSpeed : 1.f; }
-	float GetSlowAccelScalar() const { return GetSlowParams() ? GetSlowParams()->MaxAcceleration : 1.f; }
-	float GetSlowBrakingScalar() const { return GetSlowParams() ? GetSlowParams()->BrakingDeceleration : 1.f; }
-	float GetSlowGroundFrictionScalar() const { return GetSlowParams() ? GetSlowParams()->GroundFriction : 1.f; }
-	float GetSlowBrakingFrictionScalar() const { return GetSlowParams() ? GetSlowParams()->BrakingFriction : 1.f; }
-	bool SlowAffectsRootMotion() const { return GetSlowParams() ? GetSlowParams()->bAffectsRootMotion : false; }
+	float GetSlowSpeedScalar() const { const FMovementModifierParams* Params = GetSlowParams(); return Params ? Params->MaxWalkSpeed : 1.f; }
+	float GetSlowAccelScalar() const { const FMovementModifierParams* Params = GetSlowParams(); return Params ? Params->MaxAcceleration : 1.f; }
+	float GetSlowBrakingScalar() const { const FMovementModifierParams* Params = GetSlowParams(); return Params ? Params->BrakingDeceleration : 1.f; }
+	float GetSlowGroundFrictionScalar() const { const FMovementModifierParams* Params = GetSlowParams(); return Params ? Params->GroundFriction : 1.f; }
+	float GetSlowBrakingFrictionScalar() const { const FMovementModifierParams* Params = GetSlowParams(); return Params ? Params->BrakingFriction : 1.f; }
+	bool SlowAffectsRootMotion() const { const FMovementModifierParams* Params = GetSlowParams(); return Params ? Params->bAffectsRootMotion : false; }
 	
+	/**
+	 * @param bServerInitiated Apply on the server only and push to the client, instead of predicting it locally
+	 * @param Duration Seconds of movement simulation before the modifier is removed, 0 to keep it until cleared
+	 */
 	UFUNCTION(BlueprintCallable, Category="Custom Character Movement")
-	void SetSlowByTag(const FGameplayTag Tag);
+	void SetSlowByTag(const FGameplayTag Tag, bool bServerInitiated = false, float Duration = 0.f);
+
+	/** @see ScheduleChannelModifier */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category="Custom Character Movement")
+	void ScheduleSlowByTag(const FGameplayTag Tag, float Duration = 0.f);
 	
 	UFUNCTION(BlueprintCallable, Category="Custom Character Movement")
-	void ClearSlow();
+	void ClearSlow(bool bServerInitiated = false);
 
 	/* ~Slow Implementation */
 
 public:
 	/* SlowFall Implementation */
 
-	uint8 SlowFallLevel = NO_MODIFIER;
+	/** Current level of SlowFall, None if inactive */
+	FSlowFallLevel GetCurrentSlowFallLevel() const { return ModifierChannels.Get<FSlowFallLevel>().Levels[SlowFallChannel.Index]; }
 
 	UFUNCTION(BlueprintCallable, Category="Custom Character Movement")
-	bool IsSlowFallActive() const { return SlowFallLevel != NO_MODIFIER; }
-	const FFallingModifierParams* GetSlowFallParams() const { return SlowFall.Find(GetSlowFallLevel()); }
-	FGameplayTag GetSlowFallLevel() const { return SlowFallLevels.IsValidIndex(SlowFallLevel) ? SlowFallLevels[SlowFallLevel] : FGameplayTag::EmptyTag; }
-	uint8 GetSlowFallLevelIndex(const FGameplayTag& Level) const { return SlowFallLevels.IndexOfByKey(Level) > INDEX_NONE ? SlowFallLevels.IndexOfByKey(Level) : NO_MODIFIER; }
+	bool IsSlowFallActive() const { return GetCurrentSlowFallLevel() != TModifierLevelTraits<FSlowFallLevel>::None; }
+	const FFallingModifierParams* GetSlowFallParams() const { return SlowFallParamsTable.Find(GetCurrentSlowFallLevel()); }
+	FGameplayTag GetSlowFallLevel() const { const FSlowFallLevel Level = GetCurrentSlowFallLevel(); return SlowFallLevels.IsValidIndex(Level) ? SlowFallLevels[Level] : FGameplayTag::EmptyTag; }
+	FSlowFallLevel GetSlowFallLevelIndex(const FGameplayTag& Level) const { return SlowFallLevelIndex.Find(Level); }
 	virtual bool CanSlowFallInCurrentState() const;
 
-	virtual float GetSlowFallGravityZScalar() const { return GetSlowFallParams() ? GetSlowFallParams()->GetGravityScalar(Velocity) : 1.f; }
+	virtual float GetSlowFallGravityZScalar() const { const FFallingModifierParams* Params = GetSlowFallParams(); return Params ? Params->GetGravityScalar(Velocity) : 1.f; }
 	virtual bool RemoveVelocityZOnSlowFallStart() const;
 	
+	/**
+	 * @param bServerInitiated Apply on the server only and push to the client, instead of predicting it locally
+	 * @param Duration Seconds of movement simulation before the modifier is removed, 0 to keep it until cleared
+	 */
 	UFUNCTION(BlueprintCallable, Category="Custom Character Movement")
-	void SetSlowFallByTag(const FGameplayTag Tag);
+	void SetSlowFallByTag(const FGameplayTag Tag, bool bServerInitiated = false, float Duration = 0.f);
+
+	/** @see ScheduleChannelModifier */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category="Custom Character Movement")
+	void ScheduleSlowFallByTag(const FGameplayTag Tag, float Duration = 0.f);
 	
 	UFUNCTION(BlueprintCallable, Category="Custom Character Movement")
-	void ClearSlowFalling();
+	void ClearSlowFalling(bool bServerInitiated = false);
 
 	/* ~SlowFall Implementation */
 
+public:
+	/**
+	 * Rebuilds the level tags, the tag to level index and the level-indexed params tables from Haste, Slow and SlowFall
+	 * Tags added to the maps are appended to the level tags, so existing levels keep their index
+	 * Call this (or MarkModifierParamsDirty) after changing those maps at runtime, editor changes are picked up automatically
+	 * Levels are sent over the network at the width of the archetype's levels, levels added at runtime beyond those fail to serialize
+	 */
+	UFUNCTION(BlueprintCallable, Category="Custom Character Movement")
+	void RebuildModifierParams();
+
+	/** Invalidates the level index and params tables, they are rebuilt on the next lookup or modifier update */
+	void MarkModifierParamsDirty() { ModifierParamsVersion++; }
+
+	/** Rebuilds the level index and params tables if they were invalidated */
+	void EnsureModifierParams()
+	{
+		if (BuiltModifierParamsVersion != ModifierParamsVersion)
+		{
+			RebuildModifierParams();
+		}
+	}
+
+public:
+	/* Batch Implementation */
+
+	/** Adds Haste to many components in one pass, @see SetChannelModifierByTagBatch */
+	UFUNCTION(BlueprintCallable, Category="Custom Character Movement")
+	static void SetHasteByTagBatch(const TArray<UCustomMovementComponent*>& Components, const FGameplayTag Tag, bool bServerInitiated = false, float Duration = 0.f, bool bParallel = false);
+
+	/** Adds Slow to many components in one pass, e.g. an area of effect snare, @see SetChannelModifierByTagBatch */
+	UFUNCTION(BlueprintCallable, Category="Custom Character Movement")
+	static void SetSlowByTagBatch(const TArray<UCustomMovementComponent*>& Components, const FGameplayTag Tag, bool bServerInitiated = false, float Duration = 0.f, bool bParallel = false);
+
+	/** Adds SlowFall to many components in one pass, @see SetChannelModifierByTagBatch */
+	UFUNCTION(BlueprintCallable, Category="Custom Character Movement")
+	static void SetSlowFallByTagBatch(const TArray<UCustomMovementComponent*>& Components, const FGameplayTag Tag, bool bServerInitiated = false, float Duration = 0.f, bool bParallel = false);
+
+	/**
+	 * Adds a modifier to the same channel of many components in one pass
+	 * Levels are resolved on the game thread, once for components of a class sharing the level tags, then added in a single pass
+	 * A component listed more than once is modified once
+	 * @param Channel The channel, e.g. GetSlowChannel(), channels are registered in the same order by every component of a class
+	 * @param bParallel Add on worker threads for large batches, the components must not be simulating movement meanwhile
+	 */
+	static void SetChannelModifierByTagBatch(TConstArrayView<UCustomMovementComponent*> Components, FModifierChannelId Channel,
+		const FGameplayTag Tag, bool bServerInitiated, float Duration, bool bParallel);
+
+	/** The Haste channel, e.g. for SetChannelModifierByTagBatch */
+	FModifierChannelId GetHasteChannel() const { return HasteChannel; }
+
+	/** The Slow channel, e.g. for SetChannelModifierByTagBatch */
+	FModifierChannelId GetSlowChannel() const { return SlowChannel; }
+
+	/** The SlowFall channel, e.g. for SetChannelModifierByTagBatch */
+	FModifierChannelId GetSlowFallChannel() const { return SlowFallChannel; }
+
+	/** Gathers the distinct components of the characters in an overlap query result, e.g. a sphere overlap, for the batch functions */
+	static void GetComponentsFromOverlaps(TConstArrayView<FOverlapResult> Overlaps, TArray<UCustomMovementComponent*>& OutComponents);
+
+	/* ~Batch Implementation */
+
+public:
+	/* Command Queue Implementation */
+
+	/**
+	 * Thread safe, queues a modifier change that is applied at the start of the next move, in the order queued
+	 * Lets gameplay threads and tasks change modifiers without a game thread hop or a lock
+	 * @param Tag The level to add or remove, unused by Reset
+	 */
+	void QueueModifierCommand(FModifierChannelId Channel, EModifierOp Op, const FGameplayTag Tag, bool bServerInitiated = false, float Duration = 0.f);
+
+	/** Thread safe SetHasteByTag, @see QueueModifierCommand */
+	void QueueHasteByTag(const FGameplayTag Tag, bool bServerInitiated = false, float Duration = 0.f) { QueueModifierCommand(HasteChannel, EModifierOp::Add, Tag, bServerInitiated, Duration); }
+	void QueueRemoveHasteByTag(const FGameplayTag Tag, bool bServerInitiated = false) { QueueModifierCommand(HasteChannel, EModifierOp::Remove, Tag, bServerInitiated); }
+	void QueueClearHaste(bool bServerInitiated = false) { QueueModifierCommand(HasteChannel, EModifierOp::Reset, FGameplayTag::EmptyTag, bServerInitiated); }
+
+	/** Thread safe SetSlowByTag, @see QueueModifierCommand */
+	void QueueSlowByTag(const FGameplayTag Tag, bool bServerInitiated = false, float Duration = 0.f) { QueueModifierCommand(SlowChannel, EModifierOp::Add, Tag, bServerInitiated, Duration); }
+	void QueueRemoveSlowByTag(const FGameplayTag Tag, bool bServerInitiated = false) { QueueModifierCommand(SlowChannel, EModifierOp::Remove, Tag, bServerInitiated); }
+	void QueueClearSlow(bool bServerInitiated = false) { QueueModifierCommand(SlowChannel, EModifierOp::Reset, FGameplayTag::EmptyTag, bServerInitiated); }
+
+	/** Thread safe SetSlowFallByTag, @see QueueModifierCommand */
+	void QueueSlowFallByTag(const FGameplayTag Tag, bool bServerInitiated = false, float Duration = 0.f) { QueueModifierCommand(SlowFallChannel, EModifierOp::Add, Tag, bServerInitiated, Duration); }
+	void QueueRemoveSlowFallByTag(const FGameplayTag Tag, bool bServerInitiated = false) { QueueModifierCommand(SlowFallChannel, EModifierOp::Remove, Tag, bServerInitiated); }
+	void QueueClearSlowFalling(bool bServerInitiated = false) { QueueModifierCommand(SlowFallChannel, EModifierOp::Reset, FGameplayTag::EmptyTag, bServerInitiated); }
+
+protected:
+	/** Applies the queued modifier commands, on the game thread before a local move is saved or a client move is performed */
+	void DrainModifierCommands();
+
+private:
+	/** Multiple producers, consumed by DrainModifierCommands */
+	TQueue<FModifierCommand, EQueueMode::Mpsc> ModifierCommands;
+
+	/* ~Command Queue Implementation */
+
+public:
+	/* Tag Binding Implementation */
+
+	/**
+	 * Subscribes ModifierTagBindings to the tag events of an ability system, applying the tags it already has
+	 * Called from BeginPlay with the owner's ability system, call it again if it is initialized later or lives elsewhere, e.g. on the player state
+	 */
+	UFUNCTION(BlueprintCallable, Category="Custom Character Movement")
+	void BindModifierTags(UAbilitySystemComponent* AbilitySystem);
+
+	/** Unsubscribes from the bound ability system and removes the modifiers its tags applied, right away rather than queued */
+	UFUNCTION(BlueprintCallable, Category="Custom Character Movement")
+	void UnbindModifierTags();
+
+	/** A built-in channel, invalid for an unknown one */
+	FModifierChannelId GetModifierChannelId(EModifierChannel Channel) const;
+
+protected:
+	void OnModifierBindingTagChanged(const FGameplayTag Tag, int32 NewCount, int32 BindingIndex);
+
+private:
+	TWeakObjectPtr<UAbilitySystemComponent> BoundAbilitySystem;
+
+	/** Aligned with ModifierTagBindings, invalid for bindings that don't apply on this machine */
+	TArray<FDelegateHandle> ModifierTagBindingHandles;
+
+	/** Aligned with ModifierTagBindings, whether the binding has added its modifier */
+	TBitArray<> ActiveModifierTagBindings;
+
+	/* ~Tag Binding Implementation */
+
+public:
+	/**
+	 * Runtime state of every modifier channel, saved, sent and corrected as a whole
+	 * Channels are registered with the uint8 or uint16 channels by their level type, each width is a registry of its own
+	 * @see RegisterModifierChannel
+	 */
+	TModifierWidths<TModifierChannels> ModifierChannels;
+
+	/** Whether the channel is registered, safe from any thread */
+	bool IsValidModifierChannel(FModifierChannelId Channel) const;
+
+protected:
+	/**
+	 * Adds a modifier channel, so it is processed, predicted, sent and corrected alongside Haste, Slow and SlowFall
+	 * Must be called from the constructor, channels have to be registered in the same order on every machine
+	 * @tparam TLevel The level width of the channel, uint8 or uint16 for more than 254 levels
+	 */
+	template<typename TLevel>
+	FModifierChannelId RegisterModifierChannel(FModifierChannelConfig&& Config)
+	{
+		return { ModifierChannels.Get<TLevel>().Register(MoveTemp(Config)), TModifierLevelTraits<TLevel>::Width };
+	}
+
+	/**
+	 * Adds a modifier to a channel
+	 * @param Level The level index, must fit the level width of the channel
+	 * @param bServerInitiated Apply on the server only and push to the client, otherwise predicted locally and corrected by the server
+	 * @param Duration Seconds of movement simulation before the modifier is removed, 0 to keep it until reset
+	 *	Expiry follows the moves rather than world time, so a predicted modifier expires on the same move on client and server
+	 */
+	void AddChannelModifier(FModifierChannelId Channel, int32 Level, bool bServerInitiated, float Duration = 0.f);
+
+	/** Removes a single modifier of a level from a channel, of the same kind as AddChannelModifier */
+	void RemoveChannelModifier(FModifierChannelId Channel, int32 Level, bool bServerInitiated);
+
+	/**
+	 * The level of a tag in a channel, override to use the level index of channels registered by a derived class
+	 * @return INDEX_NONE if the tag isn't a level of the channel
+	 */
+	virtual int32 GetChannelLevelIndex(FModifierChannelId Channel, const FGameplayTag& Tag) const;
+
+	/**
+	 * Removes every modifier of a channel along with their timers, of the same kind as AddChannelModifier
+	 * Server initiated also clears the scheduled modifiers, on a scheduled move
+	 */
+	void ResetChannelModifiers(FModifierChannelId Channel, bool bServerInitiated);
+
+	/**
+	 * Server only, adds a modifier on a future client move and sends the schedule to the client ahead of time
+	 * Both apply it on the same simulated move, so it doesn't cause a correction as long as the client's latency is below MaxScheduledModifierLead
+	 * Without a remote client, e.g. the listen server's own character, it is applied as a server initiated modifier
+	 * @param Duration Seconds of client moves before the modifier is removed, also scheduled, 0 to keep it until reset
+	 */
+	void ScheduleChannelModifier(FModifierChannelId Channel, int32 Level, float Duration = 0.f);
+
+	/** Server only, the client move timestamp a modifier scheduled now applies at */
+	float GetScheduledModifierTimeStamp() const;
+
+	/** The client timestamp of the move being simulated, scheduled and timed modifiers apply when it reaches theirs */
+	float GetSimulatedMoveTimeStamp() const;
+
+	/** The built-in channels, each registered with the width of its level type */
+	FModifierChannelId HasteChannel;
+	FModifierChannelId SlowChannel;
+	FModifierChannelId SlowFallChannel;
+
+	/** Bumped whenever Haste, Slow or SlowFall change */
+	uint32 ModifierParamsVersion = 1;
+
+	/** The ModifierParamsVersion the level index and params tables were built from */
+	uint32 BuiltModifierParamsVersion = 0;
+
+private:
+	/** The channel functions above, on the registry of the channel's level width */
+	template<typename TLevel>
+	void AddChannelModifier(TModifierChannels<TLevel>& Channels, int32 Channel, int32 Level, bool bServerInitiated, float Duration);
+
+	template<typename TLevel>
+	void RemoveChannelModifier(TModifierChannels<TLevel>& Channels, int32 Channel, int32 Level, bool bServerInitiated);
+
+	template<typename TLevel>
+	void ResetChannelModifiers(TModifierChannels<TLevel>& Channels, int32 Channel, bool bServerInitiated);
+
+	template<typename TLevel>
+	void ScheduleChannelModifier(TModifierChannels<TLevel>& Channels, int32 Channel, int32 Level, float Duration);
+
 public:
 	virtual void ProcessModifierMovementState();
 	virtual void UpdateModifierMovementState();
@@ -639,6 +994,9 @@ public:
 	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
 	virtual void UpdateCharacterStateAfterMovement(float DeltaSeconds) override;
 
+protected:
+	virtual void ControlledCharacterMove(const FVector& InputVector, float DeltaSeconds) override;
+
 public:
 	/* ~Client Auth Implementation */
 	
@@ -683,7 +1041,16 @@ public:
 		UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition,
 		uint8 ServerMovementMode, TOptional<FRotator> OptionalRotation = TOptional<FRotator>()) override;
 
+	/** Applies the server initiated modifiers and queues the scheduled ones, which arrive with acks as well as corrections */
+	virtual void ClientHandleMoveResponse(const FCharacterMoveResponseDataContainer& MoveResponse) override;
+
+	/** Client only, the number of corrections received, e.g. to measure how often modifiers cause them */
+	UFUNCTION(BlueprintPure, Category="Custom Character Movement")
+	int32 GetNumClientCorrections() const { return NumClientCorrections; }
+
 protected:
+	int32 NumClientCorrections = 0;
+
 	virtual void OnClientCorrectionReceived(class FNetworkPredictionData_Client_Character& ClientData, float TimeStamp,
 		FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase,
 		bool bBaseRelativePosition, uint8 ServerMovementMode, FVector ServerGravityDirection) override;
@@ -704,6 +1071,12 @@ public:
 protected:
 	virtual void MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel) override;
 
+	/** The client timestamp of the last MoveAutonomous, i.e. the move the server or a replay is simulating */
+	float AutonomousMoveTimeStamp = 0.f;
+
+	/** Timestamp of the moves of a character without a remote client, which has no client timestamps, reset like a client's */
+	float LocalMoveTimeStamp = 0.f;
+
 	/** Unpack compressed flags from a saved move and set state accordingly. See FPredictedSavedMove. */
 	virtual void UpdateFromCompressedFlagsExtra(uint8 Flags);
 
@@ -760,17 +1133,8 @@ public:
 	float StartStamina;
 	float EndStamina;
 
-	// Movement Modifiers
-	FModifierSavedMove HasteLocal;							// Haste
-	FModifierSavedMove_WithCorrection HasteCorrection;		// Haste
-	FModifierSavedMove SlowLocal;							// Slow
-	FModifierSavedMove_WithCorrection SlowCorrection;		// Slow
-	FModifierSavedMove SlowFallLocal; 						// SlowFall
-	FModifierSavedMove_WithCorrection SlowFallCorrection;	// SlowFall
-	
-	uint8 HasteLevel = NO_MODIFIER;
-	uint8 SlowLevel = NO_MODIFIER;
-	uint8 SlowFallLevel = NO_MODIFIER;
+	// Movement Modifiers, for every modifier channel
+	TModifierWidths<TModifierSavedChannels> ModifierChannels;
 
 	// Bit masks used by GetCompressedFlags() to encode movement information.
 	enum CompressedFlagsExtra
@@ -0,0 +1,1779 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "ModifierImpl.h"
+
+/**
+ * Number of modifier channels stored inline before the channel arrays spill to the heap
+ * The built-in channels are Haste, Slow and SlowFall, leaving room for one more without allocating
+ */
+#ifndef CM_INLINE_MODIFIER_CHANNELS
+#define CM_INLINE_MODIFIER_CHANNELS 4
+#endif
+
+/**
+ * Maximum number of modifier channels of a level width, bounded by the presence mask of the network move data
+ * @see TModifierMoveDataChannels::Serialize
+ */
+#define CM_MAX_MODIFIER_CHANNELS 15
+
+/**
+ * Maximum number of timed modifiers pending expiry across the channels of a level width
+ * @see TModifierTimerWheel
+ */
+#ifndef CM_MAX_MODIFIER_TIMERS
+#define CM_MAX_MODIFIER_TIMERS 32
+#endif
+
+/**
+ * Maximum number of scheduled modifier changes pending across the channels of a level width
+ * @see TModifierChannels::AddScheduledModifier
+ */
+#ifndef CM_MAX_SCHEDULED_MODIFIERS
+#define CM_MAX_SCHEDULED_MODIFIERS 8
+#endif
+
+/**
+ * Number of labelled modifier states kept for delta encoding, on the client as sent and on the server as received
+ * Must divide 256, as labels are 8 bits and index the ring directly
+ * @see TModifierNetStateRing
+ */
+#ifndef CM_MODIFIER_NET_STATES
+#define CM_MODIFIER_NET_STATES 32
+#endif
+
+template<typename T>
+using TModifierChannelArray = TArray<T, TInlineAllocator<CM_INLINE_MODIFIER_CHANNELS>>;
+
+/** How the modifier stacks of a move are sent, two bits on the wire */
+enum class EModifierStateEncoding : uint8
+{
+	/** Every stack is empty, nothing else is sent */
+	Empty,
+
+	/** Every stack in full, the client has no acknowledged baseline */
+	Full,
+
+	/** Identical to the acknowledged baseline, only its label is sent */
+	Same,
+
+	/** Edits to the acknowledged baseline, a bit per unchanged stack */
+	Delta,
+};
+
+/** How a scheduled entry or a queued command changes the modifiers of its channel */
+enum class EModifierOp : uint8
+{
+	Add,
+	Remove,
+	Reset,
+};
+
+/**
+ * A change to the scheduled modifiers of a channel, applied by the first move whose client timestamp reaches TimeStamp
+ * Sent to the client ahead of time, so both ends apply it on the same simulated move
+ */
+template<typename TLevel>
+struct TModifierScheduleEntry
+{
+	/** Client move timestamp the entry applies at */
+	float TimeStamp = 0.f;
+
+	/** Sequence of the entry, acknowledged by the client */
+	uint8 Id = 0;
+
+	uint8 Channel = 0;
+	EModifierOp Op = EModifierOp::Add;
+	TLevel Level = TModifierLevelTraits<TLevel>::None;
+
+	/** Server: applied but possibly not received yet, kept until acknowledged */
+	bool bApplied = false;
+
+	/**
+	 * Whether a move at MoveTimeStamp reaches the entry
+	 * Client timestamps reset every TimeStampResetInterval, a distance beyond half of it means the move is past a reset
+	 */
+	bool IsDue(float MoveTimeStamp, float TimeStampResetInterval) const
+	{
+		const float Delta = MoveTimeStamp - TimeStamp;
+		return Delta >= 0.f || Delta < -0.5f * TimeStampResetInterval;
+	}
+};
+
+template<typename TLevel>
+using TModifierSchedule = TArray<TModifierScheduleEntry<TLevel>, TInlineAllocator<CM_MAX_SCHEDULED_MODIFIERS>>;
+
+/**
+ * A registered modifier channel, the level width it was registered with and its index among the channels of that width
+ * The same for every component of a class, channels are registered from the constructor
+ */
+struct FModifierChannelId
+{
+	int32 Index = INDEX_NONE;
+	EModifierLevelWidth Width = EModifierLevelWidth::Narrow;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+
+	bool operator==(const FModifierChannelId& Other) const { return Index == Other.Index && Width == Other.Width; }
+	bool operator!=(const FModifierChannelId& Other) const { return !(*this == Other); }
+};
+
+/**
+ * A modifier change queued from any thread, applied by the owning component at the start of its next move
+ * Holds the tag rather than the level, the level index may only be read on the game thread
+ */
+struct FModifierCommand
+{
+	FGameplayTag Tag;
+	float Duration = 0.f;
+	FModifierChannelId Channel;
+	EModifierOp Op = EModifierOp::Add;
+	bool bServerInitiated = false;
+};
+
+/**
+ * How a modifier channel is processed, bound to the owning component's properties when the channel is registered
+ * The properties stay editable, the channel only points at them
+ */
+struct FModifierChannelConfig
+{
+	/** Used for logging and serialization errors */
+	FString Name;
+
+	/** Indexed list of levels of the channel, e.g. HasteLevels */
+	const TArray<FGameplayTag>* LevelTags = nullptr;
+
+	/** The method used to combine the levels of the channel, e.g. HasteLevelMethod */
+	const EModifierLevelMethod* LevelMethod = nullptr;
+
+	/** Whether the number of modifiers is limited, e.g. bLimitMaxHastes */
+	const bool* bLimitMaxModifiers = nullptr;
+
+	/** The maximum number of modifiers when limited, e.g. MaxHastes */
+	const int32* MaxModifiers = nullptr;
+
+	/** Whether the channel can activate in the current state, e.g. CanHasteInCurrentState */
+	TFunction<bool()> CanActivate;
+
+	/** Optional, the number of levels once the level tags are rebuilt, read without rebuilding them, e.g. from the params map */
+	TFunction<int32()> CountLevels;
+
+	int32 GetNumLevels() const { return CountLevels ? CountLevels() : LevelTags->Num(); }
+};
+
+/**
+ * Wire format of a channel's wanted and applied stacks
+ * Fixed from shared config rather than read from the live properties, which may be edited at runtime on one end only
+ */
+struct FModifierChannelNetFormat
+{
+	FModifierChannelNetFormat(const FModifierChannelConfig& Config, int32 MaxLevels)
+		: Wants(CM_MAX_MODIFIER_STACK, FMath::Min(Config.GetNumLevels(), MaxLevels))
+		, Applied(*Config.bLimitMaxModifiers ? *Config.MaxModifiers : CM_MAX_MODIFIER_STACK, FMath::Min(Config.GetNumLevels(), MaxLevels))
+	{}
+
+	/** Wanted stacks are only clamped to the stack capacity */
+	FModifierStackNetFormat Wants;
+
+	/** Applied stacks are clamped to MaxModifiers when limited */
+	FModifierStackNetFormat Applied;
+};
+
+template<typename TLevel>
+struct TModifierSavedChannels;
+
+template<typename TLevel>
+struct TModifierMoveDataChannels;
+
+template<typename TLevel>
+struct TModifierResponseChannels;
+
+/**
+ * Expires timed modifiers on the client timestamps of the simulated moves, like the schedule
+ * Client and server simulate the same moves with the same timestamps, so a modifier added on the same move expires on
+ * the same move on both, without any game thread timer
+ *
+ * Hashed timer wheel: each timer is linked into the slot of its expiry tick, so advancing only visits the slots crossed
+ * since the last move, O(1) per tick regardless of the number of timers
+ * Timers further away than a revolution stay in their slot until their round comes
+ *
+ * Fixed capacity plain data, saved moves snapshot it so combined and replayed moves expire from the same state
+ */
+template<typename TLevel>
+struct TModifierTimerWheel
+{
+	static constexpr int32 NumSlots = 16;
+	static constexpr int32 SlotMask = NumSlots - 1;
+	static constexpr uint32 SlotMs = 125;
+	static constexpr int32 Capacity = CM_MAX_MODIFIER_TIMERS;
+
+	static_assert((NumSlots & SlotMask) == 0, "NumSlots must be a power of two");
+	static_assert(Capacity <= 127, "Timer links are stored as int8");
+
+	struct FTimer
+	{
+		/** Move timestamp at which the modifier expires */
+		uint32 ExpireMs;
+		int8 Next;
+		uint8 Channel;
+		bool bServerInitiated;
+		TLevel Level;
+	};
+
+	FTimer Timers[Capacity];
+	int8 SlotHeads[NumSlots];
+	int8 FreeHead;
+	int32 NumTimers;
+
+	/** Timestamp of the last move advanced to, timers added between moves count from it */
+	uint32 NowMs;
+
+	/** Whether a move was advanced to yet, timers added before the first move count from it */
+	bool bStarted;
+
+	TModifierTimerWheel() { Reset(); }
+
+	void Reset()
+	{
+		for (int32 Slot = 0; Slot < NumSlots; ++Slot)
+		{
+			SlotHeads[Slot] = INDEX_NONE;
+		}
+		for (int32 Index = 0; Index < Capacity; ++Index)
+		{
+			Timers[Index].Next = Index + 1 < Capacity ? Index + 1 : INDEX_NONE;
+		}
+		FreeHead = 0;
+		NumTimers = 0;
+		NowMs = 0;
+		bStarted = false;
+	}
+
+	bool IsEmpty() const { return NumTimers == 0; }
+
+	/** Copies another wheel, only its clock while both have no timers, e.g. the wheel of a level width without channels */
+	void CopyFrom(const TModifierTimerWheel& Other)
+	{
+		if (Other.IsEmpty())
+		{
+			if (!IsEmpty())
+			{
+				Reset();
+			}
+			NowMs = Other.NowMs;
+			bStarted = Other.bStarted;
+			return;
+		}
+		*this = Other;
+	}
+
+	static uint32 ToMs(float Seconds) { return static_cast<uint32>(FMath::RoundToInt(FMath::Max(Seconds, 0.f) * 1000.f)); }
+
+	/**
+	 * Schedules the expiry of a modifier
+	 * @param Duration Seconds of move timestamps from the last move, expires on the first move that reaches it
+	 * @return False if every timer is in use
+	 */
+	bool Add(int32 Channel, TLevel Level, bool bServerInitiated, float Duration)
+	{
+		if (FreeHead == INDEX_NONE)
+		{
+			return false;
+		}
+
+		const int32 Index = FreeHead;
+		FTimer& Timer = Timers[Index];
+		FreeHead = Timer.Next;
+
+		Timer.ExpireMs = NowMs + FMath::Max<uint32>(ToMs(Duration), 1);
+		Timer.Channel = static_cast<uint8>(Channel);
+		Timer.bServerInitiated = bServerInitiated;
+		Timer.Level = Level;
+		Link(Index);
+		NumTimers++;
+		return true;
+	}
+
+	/** Drops the timers of a channel, when its modifiers are reset */
+	void RemoveChannel(int32 Channel, bool bServerInitiated)
+	{
+		if (IsEmpty())
+		{
+			return;
+		}
+		for (int32 Slot = 0; Slot < NumSlots; ++Slot)
+		{
+			UnlinkIf(SlotHeads[Slot], [Channel, bServerInitiated](const FTimer& Timer)
+			{
+				return Timer.Channel == Channel && Timer.bServerInitiated == bServerInitiated;
+			}, [](const FTimer&) {});
+		}
+	}
+
+	/** Drops the timers of a level beyond NumModifiers, the ones expiring first, when its modifiers were removed or evicted */
+	void Trim(int32 Channel, TLevel Level, bool bServerInitiated, int32 NumModifiers)
+	{
+		for (int32 Excess = Num(Channel, Level, bServerInitiated) - NumModifiers; Excess > 0; --Excess)
+		{
+			RemoveFirstExpiring(Channel, Level, bServerInitiated);
+		}
+	}
+
+	/** Calls Func with every timer, in a deterministic order */
+	template<typename FFunc>
+	void ForEachTimer(FFunc&& Func) const
+	{
+		for (int32 Slot = 0; Slot < NumSlots; ++Slot)
+		{
+			for (int32 Index = SlotHeads[Slot]; Index != INDEX_NONE; Index = Timers[Index].Next)
+			{
+				Func(Timers[Index]);
+			}
+		}
+	}
+
+	/**
+	 * Advances to a move and expires the timers it reaches
+	 * @param MoveTimeStamp The client timestamp of the move
+	 * @param TimeStampResetInterval Client timestamps restart after it, the timers then carry over from the last move
+	 * @param OnExpired Called with each expired timer, in a deterministic order
+	 */
+	template<typename FOnExpired>
+	void Advance(float MoveTimeStamp, float TimeStampResetInterval, FOnExpired&& OnExpired)
+	{
+		const uint32 MoveMs = ToMs(MoveTimeStamp);
+		if (!bStarted)
+		{
+			bStarted = true;
+			Rebase(static_cast<int32>(MoveMs - NowMs));
+			return;
+		}
+
+		int32 DeltaMs = static_cast<int32>(MoveMs - NowMs);
+		if (DeltaMs < -static_cast<int32>(ToMs(0.5f * TimeStampResetInterval)))
+		{
+			// The move is past a reset, it covers the time from 0 to its timestamp
+			Rebase(-static_cast<int32>(NowMs));
+			DeltaMs = static_cast<int32>(MoveMs);
+		}
+		if (DeltaMs <= 0)
+		{
+			return;
+		}
+
+		const uint32 StartMs = NowMs;
+		NowMs = MoveMs;
+
+		if (IsEmpty())
+		{
+			return;
+		}
+
+		// Visit every slot whose tick was crossed, including the current one, at most one revolution
+		const uint32 StartTick = StartMs / SlotMs;
+		const uint32 NumTicks = FMath::Min<uint32>(NowMs / SlotMs - StartTick, SlotMask);
+		const uint32 Now = NowMs;
+		for (uint32 Tick = StartTick; Tick <= StartTick + NumTicks && !IsEmpty(); ++Tick)
+		{
+			UnlinkIf(SlotHeads[Tick & SlotMask], [Now](const FTimer& Timer)
+			{
+				return static_cast<int32>(Timer.ExpireMs - Now) <= 0;
+			}, OnExpired);
+		}
+	}
+
+private:
+	/** Number of timers of a level */
+	int32 Num(int32 Channel, TLevel Level, bool bServerInitiated) const
+	{
+		int32 Count = 0;
+		ForEachTimer([&](const FTimer& Timer)
+		{
+			Count += Timer.Channel == Channel && Timer.Level == Level && Timer.bServerInitiated == bServerInitiated;
+		});
+		return Count;
+	}
+
+	void RemoveFirstExpiring(int32 Channel, TLevel Level, bool bServerInitiated)
+	{
+		const FTimer* First = nullptr;
+		ForEachTimer([&](const FTimer& Timer)
+		{
+			if (Timer.Channel == Channel && Timer.Level == Level && Timer.bServerInitiated == bServerInitiated &&
+				(!First || static_cast<int32>(Timer.ExpireMs - First->ExpireMs) < 0))
+			{
+				First = &Timer;
+			}
+		});
+		if (First)
+		{
+			UnlinkIf(SlotHeads[(First->ExpireMs / SlotMs) & SlotMask], [First](const FTimer& Timer)
+			{
+				return &Timer == First;
+			}, [](const FTimer&) {});
+		}
+	}
+
+	/** Shifts the clock and every timer, relinking them into the slots of their new expiry */
+	void Rebase(int32 ShiftMs)
+	{
+		NowMs += ShiftMs;
+		if (IsEmpty())
+		{
+			return;
+		}
+
+		int8 Heads[NumSlots];
+		for (int32 Slot = 0; Slot < NumSlots; ++Slot)
+		{
+			Heads[Slot] = SlotHeads[Slot];
+			SlotHeads[Slot] = INDEX_NONE;
+		}
+		for (int32 Slot = 0; Slot < NumSlots; ++Slot)
+		{
+			for (int32 Index = Heads[Slot]; Index != INDEX_NONE; )
+			{
+				const int32 Next = Timers[Index].Next;
+
+				// Overdue timers expire on the next move
+				FTimer& Timer = Timers[Index];
+				Timer.ExpireMs += ShiftMs;
+				if (static_cast<int32>(Timer.ExpireMs - NowMs) <= 0)
+				{
+					Timer.ExpireMs = NowMs + 1;
+				}
+				Link(Index);
+				Index = Next;
+			}
+		}
+	}
+
+	void Link(int32 Index)
+	{
+		int8& Head = SlotHeads[(Timers[Index].ExpireMs / SlotMs) & SlotMask];
+		Timers[Index].Next = Head;
+		Head = static_cast<int8>(Index);
+	}
+
+	template<typename FPredicate, typename FOnRemoved>
+	void UnlinkIf(int8& Head, FPredicate&& Predicate, FOnRemoved&& OnRemoved)
+	{
+		int8* Link = &Head;
+		while (*Link != INDEX_NONE)
+		{
+			const int32 Index = *Link;
+			FTimer& Timer = Timers[Index];
+			if (Predicate(Timer))
+			{
+				*Link = Timer.Next;
+				Timer.Next = FreeHead;
+				FreeHead = Index;
+				NumTimers--;
+				OnRemoved(Timer);
+			}
+			else
+			{
+				Link = &Timer.Next;
+			}
+		}
+	}
+};
+
+/**
+ * The modifier stacks a client move sends for every channel, labelled so later moves can be encoded against it
+ */
+template<typename TLevel>
+struct TModifierNetState
+{
+	/** Label of the state, 0 while the slot is unused */
+	uint8 Id = 0;
+
+	TModifierChannelArray<TModifierMoveData_LocalPredicted<TLevel>> Local;
+	TModifierChannelArray<TModifierMoveData_WithCorrection<TLevel>> Correction;
+};
+
+/**
+ * The last CM_MODIFIER_NET_STATES labelled modifier states, indexed by label
+ * Labels are allocated in order by the client, so a slot only ever holds the newest label that maps to it,
+ * and the client never encodes against a label it has overwritten, which the server may have overwritten too
+ *
+ * The slots are allocated on first use, simulated proxies never pay for them
+ */
+template<typename TLevel>
+struct TModifierNetStateRing
+{
+	static_assert(256 % CM_MODIFIER_NET_STATES == 0, "CM_MODIFIER_NET_STATES must divide 256");
+
+	const TModifierNetState<TLevel>* Find(uint8 Id) const
+	{
+		if (Id == 0 || States.IsEmpty())
+		{
+			return nullptr;
+		}
+		const TModifierNetState<TLevel>& State = States[Id % CM_MODIFIER_NET_STATES];
+		return State.Id == Id ? &State : nullptr;
+	}
+
+	/** @return The slot of the label, overwriting whatever it held */
+	TModifierNetState<TLevel>& Store(uint8 Id)
+	{
+		check(Id != 0);
+		if (States.IsEmpty())
+		{
+			States.SetNum(CM_MODIFIER_NET_STATES);
+		}
+		TModifierNetState<TLevel>& State = States[Id % CM_MODIFIER_NET_STATES];
+		State.Id = Id;
+		return State;
+	}
+
+	void Reset()
+	{
+		States.Reset();
+	}
+
+private:
+	TArray<TModifierNetState<TLevel>> States;
+};
+
+/**
+ * Wanted modifiers and pending timers of every channel, used to restore input state after replaying saved moves
+ */
+template<typename TLevel>
+struct TModifierChannelWants
+{
+	TModifierChannelArray<TModifierLevelStack<TLevel>> Local;
+	TModifierChannelArray<TModifierLevelStack<TLevel>> Correction;
+	TModifierTimerWheel<TLevel> Timers;
+};
+
+/**
+ * Runtime state of the modifier channels of a level width, stored as parallel arrays indexed by channel
+ * Each prediction path (saved moves, network moves, corrections) is a single loop over the channels,
+ * so adding a channel only requires registering it
+ *
+ * Channels must be registered in the same order on every machine, i.e. from the component constructor
+ * @see TModifierWidths
+ */
+template<typename TLevel>
+struct TModifierChannels
+{
+	TModifierChannelArray<FModifierChannelConfig> Configs;
+
+	/** Local Predicted modifiers based on Player Input */
+	TModifierChannelArray<TMovementModifier_LocalPredicted<TLevel>> Local;
+
+	/** Local Predicted modifiers based on Player Input, that can be corrected by the server when a mismatch occurs */
+	TModifierChannelArray<TMovementModifier_WithCorrection<TLevel>> Correction;
+
+	/**
+	 * Modifiers applied by the server and pushed to the client when they change
+	 * Only modify via AddServerModifier, RemoveServerModifier and ResetServerModifiers, so ServerSerial follows
+	 */
+	TModifierChannelArray<TMovementModifier_ServerInitiated<TLevel>> Server;
+
+	/** Modifiers applied on both ends by the schedule, only modify via AddScheduledModifier */
+	TModifierChannelArray<TMovementModifier_Scheduled<TLevel>> Scheduled;
+
+	/** Current combined level of each channel */
+	TModifierChannelArray<TLevel> Levels;
+
+	/** Result of the last processing of each channel, reused while no modifier of the channel changes */
+	TModifierChannelArray<TModifierProcessCache<TLevel>> ProcessCaches;
+
+	/** Wire format of each channel, from the config at registration until InitNetFormats fixes it from the archetype */
+	TModifierChannelArray<FModifierChannelNetFormat> NetFormats;
+
+	/**
+	 * Server: bumped whenever the server modifiers of any channel change
+	 * Client: the serial of the last server modifiers received
+	 */
+	uint8 ServerSerial = 0;
+
+	/** Server: the last ServerSerial the client has received, the server modifiers are sent until they match */
+	uint8 AckedServerSerial = 0;
+
+	/**
+	 * Server: changes not yet applied or not yet acknowledged by the client
+	 * Client: changes received and not yet applied
+	 * In Id order, so both ends apply them in the same order
+	 */
+	TModifierSchedule<TLevel> Schedule;
+
+	/**
+	 * Server: the Id of the last scheduled entry
+	 * Client: the Id of the last scheduled entry received
+	 */
+	uint8 ScheduleId = 0;
+
+	/** Server: the last ScheduleId the client has received, the unacknowledged entries are sent until they match */
+	uint8 AckedScheduleId = 0;
+
+	/** Expiry of timed modifiers, advanced by the movement simulation */
+	TModifierTimerWheel<TLevel> Timers;
+
+	/**
+	 * Client: the labelled modifier states sent with moves
+	 * Server: the labelled states of the moves performed, the baselines the client may encode against
+	 */
+	TModifierNetStateRing<TLevel> NetStates;
+
+	/**
+	 * Client: the last label allocated
+	 * Server: the label of the last state stored, acknowledged to the client
+	 */
+	uint8 NetStateId = 0;
+
+	/**
+	 * Client: the acknowledged label moves are encoded against, 0 to send them in full
+	 * Server: the label the client's last move was encoded against, NetStateId is sent until they match
+	 */
+	uint8 NetStateBaselineId = 0;
+
+	/** Server: a move was encoded against a state the server doesn't have, the client is told to send in full */
+	bool bNetStateBaselineLost = false;
+
+	/** Server: the applied modifiers the client reported with its last checked move, corrections only resend the channels that differ */
+	TModifierChannelArray<TModifierLevelStack<TLevel>> ClientModifiers;
+
+	/** Server: the timestamp of the move ClientModifiers were reported with, negative when unknown */
+	float ClientModifiersTimeStamp = -1.f;
+
+	int32 Num() const { return Configs.Num(); }
+
+	/**
+	 * Adds a channel
+	 * @return The index of the channel
+	 */
+	int32 Register(FModifierChannelConfig&& Config)
+	{
+		check(Config.LevelTags && Config.LevelMethod && Config.bLimitMaxModifiers && Config.MaxModifiers && Config.CanActivate);
+		check(Num() < CM_MAX_MODIFIER_CHANNELS);
+
+		const int32 Channel = Configs.Add(MoveTemp(Config));
+		NetFormats.Emplace(Configs[Channel], TModifierLevelTraits<TLevel>::None);
+		Local.AddDefaulted();
+		Correction.AddDefaulted();
+		Server.AddDefaulted();
+		Scheduled.AddDefaulted();
+		Levels.Add(TModifierLevelTraits<TLevel>::None);
+
+		// The level kernel is resolved here, processing only resolves it again if the channel's method changes
+		TModifierProcessCache<TLevel>& Cache = ProcessCaches.AddDefaulted_GetRef();
+		Cache.KernelMethod = *Configs[Channel].LevelMethod;
+		Cache.Kernel = &FModifierStatics::GetLevelKernel<TLevel>(Cache.KernelMethod);
+		return Channel;
+	}
+
+	/** Whether a level index fits the level width, its max value is reserved for no modifier */
+	static bool IsValidLevel(int32 Level) { return Level >= 0 && Level < TModifierLevelTraits<TLevel>::None; }
+
+	/** The first level of a tag in the level tags of a channel, INDEX_NONE if there is none that fits the level width */
+	int32 FindLevel(int32 Channel, const FGameplayTag& Tag) const
+	{
+		const int32 Level = Configs[Channel].LevelTags->IndexOfByKey(Tag);
+		return IsValidLevel(Level) ? Level : INDEX_NONE;
+	}
+
+	/** Updates the level of every channel from its corrected, server and scheduled modifiers, in that order of priority */
+	void Process()
+	{
+		for (int32 Channel = 0; Channel < Num(); ++Channel)
+		{
+			const FModifierChannelConfig& Config = Configs[Channel];
+			TMovementModifier<TLevel>* const Modifiers[] = { &Correction[Channel], &Server[Channel], &Scheduled[Channel] };
+			FModifierStatics::ProcessModifiers(Levels[Channel], *Config.LevelMethod, *Config.LevelTags, *Config.bLimitMaxModifiers,
+				*Config.MaxModifiers, TModifierLevelTraits<TLevel>::None, MakeArrayView(Modifiers), Config.CanActivate, ProcessCaches[Channel]);
+		}
+	}
+
+	/**
+	 * Wire format of a channel's stacks, the same on both ends
+	 * @param bApplied Applied stacks are clamped to MaxModifiers when limited, wanted stacks only to the stack capacity
+	 */
+	const FModifierStackNetFormat& GetNetFormat(int32 Channel, bool bApplied) const
+	{
+		return bApplied ? NetFormats[Channel].Applied : NetFormats[Channel].Wants;
+	}
+
+	/**
+	 * Fixes the wire format of every channel from the channels of the archetype, which client and server load alike
+	 * Runtime edits to the level tags or limits then never change the bitstream, levels beyond the archetype's fail serialization
+	 * The archetype is only read, its level tags may not be rebuilt, so the levels are counted through the config
+	 */
+	void InitNetFormats(const TModifierChannels& Archetype)
+	{
+		if (!ensureMsgf(Archetype.Num() == Num(), TEXT("Archetype has %d modifier channels when %d are registered"), Archetype.Num(), Num()))
+		{
+			return;
+		}
+		for (int32 Channel = 0; Channel < Num(); ++Channel)
+		{
+			NetFormats[Channel] = FModifierChannelNetFormat(Archetype.Configs[Channel], TModifierLevelTraits<TLevel>::None);
+		}
+	}
+
+	/** Forces every channel to run the full processing pipeline on the next update */
+	void InvalidateProcessCaches()
+	{
+		for (TModifierProcessCache<TLevel>& Cache : ProcessCaches)
+		{
+			Cache.Invalidate();
+		}
+	}
+
+	/**
+	 * Server only, adds a modifier that is pushed to the client
+	 * @return False if the stack was full and the oldest modifier was evicted
+	 */
+	bool AddServerModifier(int32 Channel, TLevel Level)
+	{
+		const bool bAdded = Server[Channel].AddModifier(Level);
+		ServerSerial++;
+		return bAdded;
+	}
+
+	/** Server only, removes a modifier that is pushed to the client */
+	void RemoveServerModifier(int32 Channel, TLevel Level, bool bRemoveAll)
+	{
+		if (Server[Channel].RemoveModifier(Level, bRemoveAll))
+		{
+			ServerSerial++;
+		}
+	}
+
+	/** Server only, removes every modifier of the channel that is pushed to the client */
+	void ResetServerModifiers(int32 Channel)
+	{
+		if (Server[Channel].ResetModifiers())
+		{
+			ServerSerial++;
+		}
+	}
+
+	/**
+	 * Expires timed modifiers reached by this move
+	 * Call once per simulated move, before Process, with the client timestamp of the move like ApplySchedule
+	 */
+	void AdvanceTimers(float MoveTimeStamp, float TimeStampResetInterval)
+	{
+		Timers.Advance(MoveTimeStamp, TimeStampResetInterval, [this](const typename TModifierTimerWheel<TLevel>::FTimer& Timer)
+		{
+			if (!Configs.IsValidIndex(Timer.Channel))
+			{
+				return;
+			}
+			if (Timer.bServerInitiated)
+			{
+				RemoveServerModifier(Timer.Channel, Timer.Level, false);
+			}
+			else
+			{
+				Correction[Timer.Channel].RemoveModifier(Timer.Level, false);
+			}
+		});
+	}
+
+	/**
+	 * Drops the timers of a level that outnumber its modifiers, after one was removed
+	 * Removing a level takes an untimed modifier of it first, so a timer never removes a modifier it wasn't added with
+	 */
+	void TrimTimers(int32 Channel, TLevel Level, bool bServerInitiated)
+	{
+		if (!Timers.IsEmpty())
+		{
+			const TMovementModifier<TLevel>& Modifiers = bServerInitiated ? static_cast<const TMovementModifier<TLevel>&>(Server[Channel]) : Correction[Channel];
+			Timers.Trim(Channel, Level, bServerInitiated, Modifiers.WantsCounts.GetCount(Level));
+		}
+	}
+
+	/** Drops the timers of every level of a channel that outnumber its modifiers, after the oldest modifier was evicted */
+	void TrimTimers(int32 Channel, bool bServerInitiated)
+	{
+		TLevel TimedLevels[CM_MAX_MODIFIER_TIMERS];
+		int32 NumTimedLevels = 0;
+		Timers.ForEachTimer([&](const typename TModifierTimerWheel<TLevel>::FTimer& Timer)
+		{
+			if (Timer.Channel == Channel && Timer.bServerInitiated == bServerInitiated)
+			{
+				TimedLevels[NumTimedLevels++] = Timer.Level;
+			}
+		});
+		for (int32 Index = 0; Index < NumTimedLevels; ++Index)
+		{
+			TrimTimers(Channel, TimedLevels[Index], bServerInitiated);
+		}
+	}
+
+	/** Server only, whether the client is missing the latest server modifiers */
+	bool HasUnackedServerModifiers() const { return ServerSerial != AckedServerSerial; }
+
+	/** Server only, whether the client should be told which state to encode its moves against */
+	bool HasUnackedNetState() const { return bNetStateBaselineLost || NetStateBaselineId != NetStateId; }
+
+	/**
+	 * Client only, labels the modifier state of a move and picks the baseline it is encoded against
+	 * A state equal to the baseline reuses its label, and one equal to the last state sent reuses that label
+	 */
+	void ClientLabelNetState(TModifierMoveDataChannels<TLevel>& MoveData)
+	{
+		if (MoveData.IsEmpty())
+		{
+			MoveData.StateId = 0;
+			MoveData.BaselineId = 0;
+			return;
+		}
+
+		const TModifierNetState<TLevel>* Baseline = NetStates.Find(NetStateBaselineId);
+		if (Baseline && MoveData.MatchesNetState(*Baseline))
+		{
+			MoveData.StateId = NetStateBaselineId;
+			MoveData.BaselineId = NetStateBaselineId;
+			return;
+		}
+
+		const TModifierNetState<TLevel>* Last = NetStates.Find(NetStateId);
+		if (!Last || !MoveData.MatchesNetState(*Last))
+		{
+			// Label 0 is the empty state
+			NetStateId = NetStateId == TNumericLimits<uint8>::Max() ? 1 : NetStateId + 1;
+			MoveData.CopyToNetState(NetStates.Store(NetStateId));
+
+			// The baseline may have just been overwritten
+			Baseline = NetStates.Find(NetStateBaselineId);
+		}
+		MoveData.StateId = NetStateId;
+		MoveData.BaselineId = Baseline ? NetStateBaselineId : 0;
+	}
+
+	/** Client only, the server has stored the state, 0 if it lost the one moves were encoded against */
+	void OnNetStateAcked(uint8 Id)
+	{
+		if (Id == 0 || NetStates.Find(Id))
+		{
+			NetStateBaselineId = Id;
+		}
+	}
+
+	/**
+	 * Server only, schedules a change to the scheduled modifiers of a channel, sent to the client until acknowledged
+	 * @param TimeStamp The client move timestamp the change applies at
+	 * @return False if the schedule is full
+	 */
+	bool AddScheduledModifier(int32 Channel, EModifierOp Op, TLevel Level, float TimeStamp)
+	{
+		if (Schedule.Num() >= CM_MAX_SCHEDULED_MODIFIERS)
+		{
+			return false;
+		}
+
+		TModifierScheduleEntry<TLevel>& Entry = Schedule.AddDefaulted_GetRef();
+		Entry.TimeStamp = TimeStamp;
+		Entry.Id = ++ScheduleId;
+		Entry.Channel = static_cast<uint8>(Channel);
+		Entry.Op = Op;
+		Entry.Level = Level;
+		return true;
+	}
+
+	/** Whether the channel has scheduled modifiers, or changes to them that are not applied yet */
+	bool HasScheduledModifiers(int32 Channel) const
+	{
+		if (Scheduled[Channel].WantsModifiers.Num() > 0)
+		{
+			return true;
+		}
+		for (const TModifierScheduleEntry<TLevel>& Entry : Schedule)
+		{
+			if (Entry.Channel == Channel && !Entry.bApplied)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/** Server only, whether the client is missing scheduled entries */
+	bool HasUnackedSchedule() const { return ScheduleId != AckedScheduleId; }
+
+	/**
+	 * Applies the scheduled entries reached by the move
+	 * Call once per simulated move, before Process, with the client timestamp of the move
+	 * @param bKeepUntilAcked Server, applied entries are still sent until the client acknowledges them
+	 */
+	void ApplySchedule(float MoveTimeStamp, float TimeStampResetInterval, bool bKeepUntilAcked)
+	{
+		if (Schedule.IsEmpty())
+		{
+			return;
+		}
+
+		for (TModifierScheduleEntry<TLevel>& Entry : Schedule)
+		{
+			if (!Entry.bApplied && Entry.IsDue(MoveTimeStamp, TimeStampResetInterval))
+			{
+				ApplyScheduleEntry(Entry);
+				Entry.bApplied = true;
+			}
+		}
+
+		const uint8 Acked = AckedScheduleId;
+		Schedule.RemoveAll([bKeepUntilAcked, Acked](const TModifierScheduleEntry<TLevel>& Entry)
+		{
+			return Entry.bApplied && (!bKeepUntilAcked || static_cast<int8>(Entry.Id - Acked) <= 0);
+		});
+	}
+
+	void ServerMove_PerformMovement(const TModifierMoveDataChannels<TLevel>& MoveData)
+	{
+		AckedServerSerial = MoveData.AckedServerSerial;
+		AckedScheduleId = MoveData.AckedScheduleId;
+
+		// Keep the server's wanted modifiers until the client resends in full, a mismatch is corrected as usual
+		if (MoveData.bMissingBaseline)
+		{
+			bNetStateBaselineLost = true;
+			return;
+		}
+		bNetStateBaselineLost = false;
+
+		// Store the state so later moves can be encoded against it, empty moves need no acknowledgement
+		if (MoveData.StateId != 0)
+		{
+			MoveData.CopyToNetState(NetStates.Store(MoveData.StateId));
+			NetStateId = MoveData.StateId;
+			NetStateBaselineId = MoveData.BaselineId;
+		}
+		else
+		{
+			NetStateBaselineId = NetStateId;
+		}
+
+		const int32 NumChannels = FMath::Min(Num(), MoveData.Correction.Num());
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			Correction[Channel].ServerMove_PerformMovement(MoveData.Correction[Channel].WantsModifiers);
+		}
+	}
+
+	/** @return True if any channel differs from the client's */
+	bool ServerCheckClientError(const TModifierMoveDataChannels<TLevel>& MoveData) const
+	{
+		if (MoveData.bMissingBaseline)
+		{
+			return false;
+		}
+
+		const int32 NumChannels = FMath::Min(Num(), MoveData.Correction.Num());
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			if (Correction[Channel].ServerCheckClientError(MoveData.Correction[Channel].Modifiers))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/** Server only, keeps the applied modifiers the client reported with a checked move, unknown when they couldn't be decoded */
+	void ServerCacheClientModifiers(const TModifierMoveDataChannels<TLevel>& MoveData, float ClientTimeStamp)
+	{
+		if (MoveData.bMissingBaseline || MoveData.Correction.Num() != Num())
+		{
+			ClientModifiersTimeStamp = -1.f;
+			return;
+		}
+
+		ClientModifiers.SetNum(Num(), EAllowShrinking::No);
+		for (int32 Channel = 0; Channel < Num(); ++Channel)
+		{
+			ClientModifiers[Channel] = MoveData.Correction[Channel].Modifiers;
+		}
+		ClientModifiersTimeStamp = ClientTimeStamp;
+	}
+
+	/**
+	 * Client only, applies the corrected modifiers
+	 * @param CorrectedMove The saved move the correction is for, unchanged channels were not sent and take the modifiers it reported
+	 */
+	void OnClientCorrectionReceived(const TModifierResponseChannels<TLevel>& Response, const TModifierSavedChannels<TLevel>* CorrectedMove)
+	{
+		const int32 NumChannels = FMath::Min(Num(), Response.Correction.Num());
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			if (Response.CorrectionChangedMask & (1 << Channel))
+			{
+				Correction[Channel].OnClientCorrectionReceived(Response.Correction[Channel].Modifiers);
+			}
+			else if (CorrectedMove && Channel < CorrectedMove->Num())
+			{
+				Correction[Channel].OnClientCorrectionReceived(CorrectedMove->Correction[Channel].Modifiers);
+			}
+		}
+	}
+
+	/** Client only, queues the scheduled entries that are newer than the last ones received, and applies the server modifiers if they are newer */
+	void OnServerModifiersReceived(const TModifierResponseChannels<TLevel>& Response)
+	{
+		if (Response.bHasNetStateAck)
+		{
+			OnNetStateAcked(Response.AckedNetStateId);
+		}
+
+		if (Response.bHasSchedule)
+		{
+			for (const TModifierScheduleEntry<TLevel>& Entry : Response.Schedule)
+			{
+				if (static_cast<int8>(Entry.Id - ScheduleId) <= 0 || !Configs.IsValidIndex(Entry.Channel))
+				{
+					continue;
+				}
+
+				// The server never has more pending than fit, but apply rather than drop if it somehow does
+				if (Schedule.Num() < CM_MAX_SCHEDULED_MODIFIERS)
+				{
+					Schedule.Add(Entry);
+				}
+				else
+				{
+					ApplyScheduleEntry(Entry);
+				}
+				ScheduleId = Entry.Id;
+			}
+		}
+
+		// Responses are unreliable and may arrive out of order, the serial wraps so compare the signed distance
+		if (!Response.bHasServerModifiers || static_cast<int8>(Response.ServerSerial - ServerSerial) <= 0)
+		{
+			return;
+		}
+
+		const int32 NumChannels = FMath::Min(Num(), Response.Server.Num());
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			Server[Channel].OnServerModifiersReceived(Response.Server[Channel].Modifiers);
+		}
+		ServerSerial = Response.ServerSerial;
+	}
+
+	void ApplyScheduleEntry(const TModifierScheduleEntry<TLevel>& Entry)
+	{
+		TMovementModifier_Scheduled<TLevel>& Modifier = Scheduled[Entry.Channel];
+		switch (Entry.Op)
+		{
+		case EModifierOp::Add:
+			ensureMsgf(Modifier.AddModifier(Entry.Level), TEXT("Scheduled %s modifier stack is full, the oldest modifier was evicted. Increase CM_MAX_MODIFIER_STACK"),
+				*Configs[Entry.Channel].Name);
+			break;
+		case EModifierOp::Remove:
+			Modifier.RemoveModifier(Entry.Level, false);
+			break;
+		case EModifierOp::Reset:
+			Modifier.ResetModifiers();
+			break;
+		}
+	}
+
+	void SaveWants(TModifierChannelWants<TLevel>& OutWants) const
+	{
+		OutWants.Local.SetNum(Num(), EAllowShrinking::No);
+		OutWants.Correction.SetNum(Num(), EAllowShrinking::No);
+		for (int32 Channel = 0; Channel < Num(); ++Channel)
+		{
+			OutWants.Local[Channel] = Local[Channel].WantsModifiers;
+			OutWants.Correction[Channel] = Correction[Channel].WantsModifiers;
+		}
+		OutWants.Timers.CopyFrom(Timers);
+	}
+
+	void RestoreWants(const TModifierChannelWants<TLevel>& Wants)
+	{
+		for (int32 Channel = 0; Channel < Num(); ++Channel)
+		{
+			Local[Channel].SetWantsModifiers(Wants.Local[Channel]);
+			Correction[Channel].SetWantsModifiers(Wants.Correction[Channel]);
+		}
+		Timers.CopyFrom(Wants.Timers);
+	}
+};
+
+/**
+ * FSavedMove_Character
+ * Saved modifier state of every channel
+ */
+template<typename TLevel>
+struct TModifierSavedChannels
+{
+	TModifierChannelArray<TModifierSavedMove<TLevel>> Local;
+	TModifierChannelArray<TModifierSavedMove_WithCorrection<TLevel>> Correction;
+	TModifierChannelArray<TLevel> Levels;
+
+	/** The last server modifiers serial received when the move was made */
+	uint8 AckedServerSerial = 0;
+
+	/** The last scheduled entry received when the move was made */
+	uint8 AckedScheduleId = 0;
+
+	/** Timers at the start of the move, restored when the move is combined or replayed */
+	TModifierTimerWheel<TLevel> Timers;
+
+	int32 Num() const { return Levels.Num(); }
+
+	void Clear()
+	{
+		AckedServerSerial = 0;
+		AckedScheduleId = 0;
+		Timers.Reset();
+		for (int32 Channel = 0; Channel < Num(); ++Channel)
+		{
+			Local[Channel].Clear();
+			Correction[Channel].Clear();
+			Levels[Channel] = TModifierLevelTraits<TLevel>::None;
+		}
+	}
+
+	/** Sizes the saved channels to match the component, saved moves are pooled so this only allocates the first time */
+	void SetNumChannels(int32 NumChannels)
+	{
+		if (Num() != NumChannels)
+		{
+			Local.SetNum(NumChannels);
+			Correction.SetNum(NumChannels);
+			Levels.Init(TModifierLevelTraits<TLevel>::None, NumChannels);
+		}
+	}
+
+	bool CanCombineWith(const TModifierSavedChannels& NewMove) const
+	{
+		if (Num() != NewMove.Num())
+		{
+			return false;
+		}
+		for (int32 Channel = 0; Channel < Num(); ++Channel)
+		{
+			if (!Local[Channel].CanCombineWith(NewMove.Local[Channel].WantsModifiers)) { return false; }
+			if (!Correction[Channel].CanCombineWith(NewMove.Correction[Channel].WantsModifiers)) { return false; }
+
+			// Without this, the change/start/stop events will trigger twice causing de-sync, so we don't combine moves if the level changes
+			if (Levels[Channel] != NewMove.Levels[Channel]) { return false; }
+		}
+		return true;
+	}
+
+	void SetInitialPosition(const TModifierChannels<TLevel>& Channels)
+	{
+		SetNumChannels(Channels.Num());
+		Timers.CopyFrom(Channels.Timers);
+		for (int32 Channel = 0; Channel < Num(); ++Channel)
+		{
+			Local[Channel].SetInitialPosition(Channels.Local[Channel].WantsModifiers);
+			Correction[Channel].SetInitialPosition(Channels.Correction[Channel].WantsModifiers);
+			Levels[Channel] = Channels.Levels[Channel];
+		}
+	}
+
+	void SetMoveFor(const TModifierChannels<TLevel>& Channels)
+	{
+		SetNumChannels(Channels.Num());
+		AckedServerSerial = Channels.ServerSerial;
+		AckedScheduleId = Channels.ScheduleId;
+		for (int32 Channel = 0; Channel < Num(); ++Channel)
+		{
+			Local[Channel].SetMoveFor(Channels.Local[Channel].WantsModifiers);
+			Correction[Channel].SetMoveFor(Channels.Correction[Channel].WantsModifiers);
+		}
+	}
+
+	/** Rewinds the component to the start of this move before it is replayed, so its timers only advance by the move's own time */
+	void PrepMoveFor(TModifierChannels<TLevel>& Channels) const
+	{
+		Channels.Timers.CopyFrom(Timers);
+
+		const int32 NumChannels = FMath::Min(Num(), Channels.Num());
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			Channels.Levels[Channel] = Levels[Channel];
+		}
+	}
+
+	void PostUpdate(const TModifierChannels<TLevel>& Channels)
+	{
+		const int32 NumChannels = FMath::Min(Num(), Channels.Num());
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			Correction[Channel].PostUpdate(Channels.Correction[Channel].Modifiers);
+		}
+	}
+
+	/** Reverts the component to the state of this (older) move, so the combined move replays from it */
+	void CombineWith(TModifierChannels<TLevel>& Channels) const
+	{
+		Channels.Timers.CopyFrom(Timers);
+
+		const int32 NumChannels = FMath::Min(Num(), Channels.Num());
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			Channels.Local[Channel].CombineWith(Local[Channel].WantsModifiers);
+			Channels.Correction[Channel].CombineWith(Correction[Channel].WantsModifiers);
+			Channels.Levels[Channel] = Levels[Channel];
+		}
+	}
+
+	bool IsImportantMove(const TModifierSavedChannels& LastAckedMove) const
+	{
+		if (Num() != LastAckedMove.Num())
+		{
+			return true;
+		}
+		for (int32 Channel = 0; Channel < Num(); ++Channel)
+		{
+			if (Local[Channel].IsImportantMove(LastAckedMove.Local[Channel].WantsModifiers)) { return true; }
+			if (Correction[Channel].IsImportantMove(LastAckedMove.Correction[Channel].WantsModifiers)) { return true; }
+		}
+		return false;
+	}
+};
+
+/**
+ * FCharacterNetworkMoveData
+ * Modifier move data of every channel, in channel order on the wire
+ */
+template<typename TLevel>
+struct TModifierMoveDataChannels
+{
+	TModifierChannelArray<TModifierMoveData_LocalPredicted<TLevel>> Local;
+	TModifierChannelArray<TModifierMoveData_WithCorrection<TLevel>> Correction;
+
+	/** Acknowledges the server modifiers, which are never sent back to the server themselves */
+	uint8 AckedServerSerial = 0;
+
+	/** Acknowledges the scheduled entries */
+	uint8 AckedScheduleId = 0;
+
+	/** Label of the modifier state, 0 when every stack is empty */
+	uint8 StateId = 0;
+
+	/** Label of the acknowledged state the stacks are encoded against, 0 when sent in full */
+	uint8 BaselineId = 0;
+
+	/** Server, the stacks were encoded against a state the server doesn't have, so they couldn't be decoded */
+	bool bMissingBaseline = false;
+
+	void ClientFillNetworkMoveData(const TModifierSavedChannels<TLevel>& SavedMove, TModifierChannels<TLevel>& Channels)
+	{
+		AckedServerSerial = SavedMove.AckedServerSerial;
+		AckedScheduleId = SavedMove.AckedScheduleId;
+		Local.SetNum(SavedMove.Num(), EAllowShrinking::No);
+		Correction.SetNum(SavedMove.Num(), EAllowShrinking::No);
+		for (int32 Channel = 0; Channel < SavedMove.Num(); ++Channel)
+		{
+			Local[Channel].ClientFillNetworkMoveData(SavedMove.Local[Channel].WantsModifiers);
+			Correction[Channel].ClientFillNetworkMoveData(SavedMove.Correction[Channel].WantsModifiers, SavedMove.Correction[Channel].Modifiers);
+		}
+		Channels.ClientLabelNetState(*this);
+	}
+
+	bool IsEmpty() const
+	{
+		for (int32 Channel = 0; Channel < Local.Num(); ++Channel)
+		{
+			if (!Local[Channel].IsEmpty() || !Correction[Channel].IsEmpty())
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Whether the other move data serializes to the same bits, e.g. the new move of the same packet
+	 * Labels wrap, so an old move may carry the label of a different state and the stacks are compared as well
+	 */
+	bool operator==(const TModifierMoveDataChannels& Other) const
+	{
+		if (StateId != Other.StateId || BaselineId != Other.BaselineId || AckedServerSerial != Other.AckedServerSerial
+			|| AckedScheduleId != Other.AckedScheduleId || Local.Num() != Other.Local.Num())
+		{
+			return false;
+		}
+		for (int32 Channel = 0; Channel < Local.Num(); ++Channel)
+		{
+			if (Local[Channel].WantsModifiers != Other.Local[Channel].WantsModifiers
+				|| Correction[Channel].WantsModifiers != Other.Correction[Channel].WantsModifiers
+				|| Correction[Channel].Modifiers != Other.Correction[Channel].Modifiers)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool MatchesNetState(const TModifierNetState<TLevel>& State) const
+	{
+		if (State.Local.Num() != Local.Num())
+		{
+			return false;
+		}
+		for (int32 Channel = 0; Channel < Local.Num(); ++Channel)
+		{
+			if (Local[Channel].WantsModifiers != State.Local[Channel].WantsModifiers
+				|| Correction[Channel].WantsModifiers != State.Correction[Channel].WantsModifiers
+				|| Correction[Channel].Modifiers != State.Correction[Channel].Modifiers)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void CopyToNetState(TModifierNetState<TLevel>& State) const
+	{
+		State.Local = Local;
+		State.Correction = Correction;
+	}
+
+	/**
+	 * Serializes the stacks against the last state the server acknowledged, then the acks of the server serial and schedule
+	 * A move whose stacks are all empty or unchanged from the baseline costs a few bits, otherwise only the edits are sent
+	 * Without a baseline, e.g. after the server lost it, the stacks are sent in full behind a presence mask
+	 * The channel count isn't sent, both ends register the same channels
+	 */
+	bool Serialize(FArchive& Ar, const TModifierChannels<TLevel>& Channels)
+	{
+		const int32 NumChannels = Channels.Num();
+		if (Ar.IsLoading())
+		{
+			Local.SetNum(NumChannels, EAllowShrinking::No);
+			Correction.SetNum(NumChannels, EAllowShrinking::No);
+		}
+		else if (!ensureMsgf(Local.Num() == NumChannels, TEXT("Serializing modifier move data with %d channels when %d are registered"), Local.Num(), NumChannels))
+		{
+			Ar.SetError();
+			return false;
+		}
+
+		EModifierStateEncoding Encoding = EModifierStateEncoding::Empty;
+		if (Ar.IsSaving() && StateId != 0)
+		{
+			Encoding = BaselineId == 0 ? EModifierStateEncoding::Full : BaselineId == StateId ? EModifierStateEncoding::Same : EModifierStateEncoding::Delta;
+		}
+		uint8 EncodingBits = static_cast<uint8>(Encoding);
+		Ar.SerializeBits(&EncodingBits, 2);
+		Encoding = static_cast<EModifierStateEncoding>(EncodingBits);
+
+		// Label of the state, and of the baseline unless it is the state itself
+		if (Encoding != EModifierStateEncoding::Empty)
+		{
+			Ar << StateId;
+		}
+		if (Encoding == EModifierStateEncoding::Delta)
+		{
+			Ar << BaselineId;
+		}
+		if (Ar.IsLoading())
+		{
+			StateId = Encoding == EModifierStateEncoding::Empty ? 0 : StateId;
+			BaselineId = Encoding == EModifierStateEncoding::Same ? StateId : Encoding == EModifierStateEncoding::Delta ? BaselineId : 0;
+			if ((Encoding != EModifierStateEncoding::Empty && StateId == 0) || (Encoding == EModifierStateEncoding::Delta && BaselineId == 0))
+			{
+				Ar.SetError();
+				return false;
+			}
+		}
+
+		const TModifierNetState<TLevel>* Baseline = BaselineId != 0 ? Channels.NetStates.Find(BaselineId) : nullptr;
+		if (Baseline && Baseline->Local.Num() != NumChannels)
+		{
+			Baseline = nullptr;
+		}
+		if (Ar.IsSaving() && BaselineId != 0 && !ensureMsgf(Baseline, TEXT("Serializing modifier move data against state %d which isn't stored"), BaselineId))
+		{
+			Ar.SetError();
+			return false;
+		}
+		bMissingBaseline = Ar.IsLoading() && BaselineId != 0 && !Baseline;
+
+		switch (Encoding)
+		{
+		case EModifierStateEncoding::Empty:
+			if (Ar.IsLoading())
+			{
+				ResetStacks();
+			}
+			break;
+		case EModifierStateEncoding::Full:
+			SerializeFull(Ar, Channels);
+			break;
+		case EModifierStateEncoding::Same:
+			if (Ar.IsLoading())
+			{
+				if (Baseline)
+				{
+					Local = Baseline->Local;
+					Correction = Baseline->Correction;
+				}
+				else
+				{
+					ResetStacks();
+				}
+			}
+			break;
+		case EModifierStateEncoding::Delta:
+			for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+			{
+				const FString& Name = Channels.Configs[Channel].Name;
+				const FModifierStackNetFormat& WantsFormat = Channels.GetNetFormat(Channel, false);
+				FModifierStatics::NetSerializeDelta(Local[Channel].WantsModifiers, Baseline ? &Baseline->Local[Channel].WantsModifiers : nullptr, Ar, Name, WantsFormat);
+				FModifierStatics::NetSerializeDelta(Correction[Channel].WantsModifiers, Baseline ? &Baseline->Correction[Channel].WantsModifiers : nullptr, Ar, Name, WantsFormat);
+				FModifierStatics::NetSerializeDelta(Correction[Channel].Modifiers, Baseline ? &Baseline->Correction[Channel].Modifiers : nullptr, Ar, Name, Channels.GetNetFormat(Channel, true));
+			}
+			break;
+		}
+
+		uint8 AckMask = 0;
+		if (Ar.IsSaving())
+		{
+			AckMask |= AckedServerSerial != 0 ? 1 : 0;
+			AckMask |= AckedScheduleId != 0 ? 2 : 0;
+		}
+		Ar.SerializeBits(&AckMask, 2);
+
+		if (AckMask & 1)
+		{
+			Ar << AckedServerSerial;
+		}
+		else if (Ar.IsLoading())
+		{
+			AckedServerSerial = 0;
+		}
+
+		if (AckMask & 2)
+		{
+			Ar << AckedScheduleId;
+		}
+		else if (Ar.IsLoading())
+		{
+			AckedScheduleId = 0;
+		}
+		return !Ar.IsError();
+	}
+
+private:
+	void ResetStacks()
+	{
+		for (int32 Channel = 0; Channel < Local.Num(); ++Channel)
+		{
+			Local[Channel].Reset();
+			Correction[Channel].Reset();
+		}
+	}
+
+	/** A presence mask of two bits per channel (local, correction), then only the stacks that have data */
+	void SerializeFull(FArchive& Ar, const TModifierChannels<TLevel>& Channels)
+	{
+		const int32 NumChannels = Channels.Num();
+		uint32 PresenceMask = 0;
+		if (Ar.IsSaving())
+		{
+			for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+			{
+				PresenceMask |= (Local[Channel].IsEmpty() ? 0u : 1u) << (Channel * 2);
+				PresenceMask |= (Correction[Channel].IsEmpty() ? 0u : 1u) << (Channel * 2 + 1);
+			}
+		}
+		Ar.SerializeBits(&PresenceMask, NumChannels * 2);
+
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			if (PresenceMask & (1u << (Channel * 2)))
+			{
+				Local[Channel].Serialize(Ar, Channels.Configs[Channel].Name, Channels.GetNetFormat(Channel, false));
+			}
+			else if (Ar.IsLoading())
+			{
+				Local[Channel].Reset();
+			}
+
+			if (PresenceMask & (1u << (Channel * 2 + 1)))
+			{
+				Correction[Channel].Serialize(Ar, Channels.Configs[Channel].Name, Channels.GetNetFormat(Channel, false), Channels.GetNetFormat(Channel, true));
+			}
+			else if (Ar.IsLoading())
+			{
+				Correction[Channel].Reset();
+			}
+		}
+	}
+};
+
+/**
+ * FCharacterMoveResponseDataContainer
+ * Corrected modifiers of every channel, in channel order on the wire
+ */
+template<typename TLevel>
+struct TModifierResponseChannels
+{
+	TModifierChannelArray<TModifierMoveResponse<TLevel>> Correction;
+
+	/** Wanted server modifiers, only sent until the client acknowledges ServerSerial */
+	TModifierChannelArray<TModifierMoveResponse<TLevel>> Server;
+	uint8 ServerSerial = 0;
+	bool bHasServerModifiers = false;
+
+	/** Scheduled entries the client has not acknowledged yet */
+	TModifierSchedule<TLevel> Schedule;
+	bool bHasSchedule = false;
+
+	/** The channels whose corrected modifiers differ from the ones the client reported with the corrected move, only those are sent */
+	uint16 CorrectionChangedMask = 0;
+	static_assert(CM_MAX_MODIFIER_CHANNELS <= 16, "CorrectionChangedMask holds a bit per channel");
+
+	/** The last client modifier state the server stored, only sent until the client encodes its moves against it */
+	uint8 AckedNetStateId = 0;
+	bool bHasNetStateAck = false;
+
+	void ServerFillResponseData(const TModifierChannels<TLevel>& Channels)
+	{
+		bHasNetStateAck = Channels.HasUnackedNetState();
+		AckedNetStateId = Channels.bNetStateBaselineLost ? 0 : Channels.NetStateId;
+
+		bHasServerModifiers = Channels.HasUnackedServerModifiers();
+		if (bHasServerModifiers)
+		{
+			ServerSerial = Channels.ServerSerial;
+			Server.SetNum(Channels.Num(), EAllowShrinking::No);
+			for (int32 Channel = 0; Channel < Channels.Num(); ++Channel)
+			{
+				Server[Channel].ServerFillResponseData(Channels.Server[Channel].WantsModifiers);
+			}
+		}
+
+		Schedule.Reset();
+		bHasSchedule = Channels.HasUnackedSchedule();
+		if (bHasSchedule)
+		{
+			for (const TModifierScheduleEntry<TLevel>& Entry : Channels.Schedule)
+			{
+				if (static_cast<int8>(Entry.Id - Channels.AckedScheduleId) > 0)
+				{
+					Schedule.Add(Entry);
+				}
+			}
+		}
+	}
+
+	/**
+	 * Serializes the server modifiers, sent with acks as well as corrections, a single bit while the client is up to date
+	 * The channel count isn't sent, both ends register the same channels
+	 */
+	bool SerializeServerModifiers(FArchive& Ar, const TModifierChannels<TLevel>& Channels)
+	{
+		Ar.SerializeBits(&bHasServerModifiers, 1);
+		if (!bHasServerModifiers)
+		{
+			return !Ar.IsError();
+		}
+
+		Ar << ServerSerial;
+		if (Ar.IsLoading())
+		{
+			Server.SetNum(Channels.Num(), EAllowShrinking::No);
+		}
+		else if (!ensureMsgf(Server.Num() == Channels.Num(), TEXT("Serializing server modifiers with %d channels when %d are registered"), Server.Num(), Channels.Num()))
+		{
+			Ar.SetError();
+			return false;
+		}
+
+		for (int32 Channel = 0; Channel < Channels.Num(); ++Channel)
+		{
+			// The server's wanted modifiers, not clamped to the max
+			FModifierStatics::NetSerialize(Server[Channel].Modifiers, Ar, Channels.Configs[Channel].Name, Channels.GetNetFormat(Channel, false));
+		}
+		return !Ar.IsError();
+	}
+
+	/** Serializes the acknowledgement of the client's modifier state, sent with acks as well as corrections, a single bit while the client is up to date */
+	bool SerializeNetStateAck(FArchive& Ar)
+	{
+		Ar.SerializeBits(&bHasNetStateAck, 1);
+		if (bHasNetStateAck)
+		{
+			Ar << AckedNetStateId;
+		}
+		return !Ar.IsError();
+	}
+
+	/** Serializes the unacknowledged scheduled entries, sent with acks as well as corrections, a single bit while the client is up to date */
+	bool SerializeSchedule(FArchive& Ar, const TModifierChannels<TLevel>& Channels)
+	{
+		Ar.SerializeBits(&bHasSchedule, 1);
+		if (!bHasSchedule)
+		{
+			return !Ar.IsError();
+		}
+
+		uint32 NumEntries = Schedule.Num();
+		Ar.SerializeInt(NumEntries, CM_MAX_SCHEDULED_MODIFIERS + 1);
+		if (Ar.IsLoading())
+		{
+			Schedule.SetNum(NumEntries, EAllowShrinking::No);
+		}
+
+		for (TModifierScheduleEntry<TLevel>& Entry : Schedule)
+		{
+			Ar << Entry.Id;
+			Ar << Entry.TimeStamp;
+
+			uint32 Channel = Entry.Channel;
+			Ar.SerializeInt(Channel, CM_MAX_MODIFIER_CHANNELS);
+			if (!Channels.Configs.IsValidIndex(static_cast<int32>(Channel)))
+			{
+				Ar.SetError();
+				return false;
+			}
+			Entry.Channel = static_cast<uint8>(Channel);
+
+			uint8 Op = static_cast<uint8>(Entry.Op);
+			Ar.SerializeBits(&Op, 2);
+			if (Ar.IsLoading() && Op > static_cast<uint8>(EModifierOp::Reset))
+			{
+				Ar.SetError();
+				return false;
+			}
+			Entry.Op = static_cast<EModifierOp>(Op);
+
+			// At the width of the channel's wanted stacks, a level the channel doesn't have fails
+			if (Entry.Op != EModifierOp::Reset && !FModifierStatics::NetSerializeLevel(Entry.Level, Ar, Channels.Configs[Channel].Name, Channels.GetNetFormat(Channel, false)))
+			{
+				return false;
+			}
+		}
+		return !Ar.IsError();
+	}
+
+	/**
+	 * Server only, fills the corrected modifiers
+	 * @param CorrectedTimeStamp The move the correction is for, channels are compared against the modifiers the client reported with it when known
+	 */
+	void ServerFillCorrectionData(const TModifierChannels<TLevel>& Channels, float CorrectedTimeStamp)
+	{
+		const bool bHasClientModifiers = Channels.ClientModifiersTimeStamp == CorrectedTimeStamp && Channels.ClientModifiers.Num() == Channels.Num();
+
+		CorrectionChangedMask = 0;
+		Correction.SetNum(Channels.Num(), EAllowShrinking::No);
+		for (int32 Channel = 0; Channel < Channels.Num(); ++Channel)
+		{
+			Correction[Channel].ServerFillResponseData(Channels.Correction[Channel].Modifiers);
+			if (!bHasClientModifiers || Channels.Correction[Channel].Modifiers != Channels.ClientModifiers[Channel])
+			{
+				CorrectionChangedMask |= 1 << Channel;
+			}
+		}
+	}
+
+	/**
+	 * Serializes the corrected modifiers, only sent with corrections
+	 * A bit per channel, followed by the stack only for the channels that differ from the client's
+	 */
+	bool Serialize(FArchive& Ar, const TModifierChannels<TLevel>& Channels)
+	{
+		if (Ar.IsLoading())
+		{
+			Correction.SetNum(Channels.Num(), EAllowShrinking::No);
+		}
+		else if (!ensureMsgf(Correction.Num() == Channels.Num(), TEXT("Serializing modifier response with %d channels when %d are registered"), Correction.Num(), Channels.Num()))
+		{
+			Ar.SetError();
+			return false;
+		}
+
+		if (Ar.IsLoading())
+		{
+			CorrectionChangedMask = 0;
+		}
+
+		for (int32 Channel = 0; Channel < Channels.Num(); ++Channel)
+		{
+			uint8 bChanged = (CorrectionChangedMask >> Channel) & 1;
+			Ar.SerializeBits(&bChanged, 1);
+			if (!bChanged)
+			{
+				continue;
+			}
+
+			CorrectionChangedMask |= 1 << Channel;
+			FModifierStatics::NetSerialize(Correction[Channel].Modifiers, Ar, Channels.Configs[Channel].Name, Channels.GetNetFormat(Channel, true));
+		}
+		return !Ar.IsError();
+	}
+};
+
+/**
+ * One container per level width, e.g. the registry of uint8 channels and the registry of uint16 channels of a component
+ * A channel is registered into the registry of its level type, so each width keeps its own contiguous arrays and
+ * every prediction path stays a single loop over the channels of a width, once per width
+ */
+template<template<typename> class TPerWidth>
+struct TModifierWidths
+{
+	TPerWidth<uint8> Narrow;
+	TPerWidth<uint16> Wide;
+
+	template<typename TLevel>
+	TPerWidth<TLevel>& Get()
+	{
+		if constexpr (TModifierLevelTraits<TLevel>::Width == EModifierLevelWidth::Narrow) { return Narrow; }
+		else { return Wide; }
+	}
+
+	template<typename TLevel>
+	const TPerWidth<TLevel>& Get() const
+	{
+		if constexpr (TModifierLevelTraits<TLevel>::Width == EModifierLevelWidth::Narrow) { return Narrow; }
+		else { return Wide; }
+	}
+
+	/** Calls Func with the container of a width, e.g. of the width of a channel id */
+	template<typename FFunc>
+	decltype(auto) Visit(EModifierLevelWidth Width, FFunc&& Func)
+	{
+		if (Width == EModifierLevelWidth::Wide) { return Func(Wide); }
+		return Func(Narrow);
+	}
+
+	template<typename FFunc>
+	decltype(auto) Visit(EModifierLevelWidth Width, FFunc&& Func) const
+	{
+		if (Width == EModifierLevelWidth::Wide) { return Func(Wide); }
+		return Func(Narrow);
+	}
+
+	bool operator==(const TModifierWidths& Other) const { return Narrow == Other.Narrow && Wide == Other.Wide; }
+	bool operator!=(const TModifierWidths& Other) const { return !(*this == Other); }
+};
+
+/**
+ * Calls Func with the uint8 containers of every argument, then with their uint16 containers
+ * e.g. ForEachModifierWidth([](auto& Saved, const auto& Channels) { Saved.SetMoveFor(Channels); }, SavedChannels, ModifierChannels);
+ */
+template<typename FFunc, typename... TWidths>
+void ForEachModifierWidth(FFunc&& Func, TWidths&&... Widths)
+{
+	Func(Widths.Narrow...);
+	Func(Widths.Wide...);
+}
+
+/** Whether Func returns true for the containers of any width, @see ForEachModifierWidth */
+template<typename FFunc, typename... TWidths>
+bool AnyModifierWidth(FFunc&& Func, TWidths&&... Widths)
+{
+	return Func(Widths.Narrow...) || Func(Widths.Wide...);
+}
+
+/** Whether Func returns true for the containers of every width, @see ForEachModifierWidth */
+template<typename FFunc, typename... TWidths>
+bool AllModifierWidths(FFunc&& Func, TWidths&&... Widths)
+{
+	return Func(Widths.Narrow...) && Func(Widths.Wide...);
+}
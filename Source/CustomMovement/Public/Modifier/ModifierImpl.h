@@ -3,59 +3,144 @@
 #include "CoreMinimal.h"
 #include "GameplayTagContainer.h"
 #include "ModifierTypes.h"
+#include "ModifierStack.h"
 
-// UINT8_MAX is NO_MODIFIER, so UINT8_MAX-1 is the max for uint8 -- NO_MODIFIER is defined in ModifierTypes.h
-using TModSize = uint8;  // If you want more than 254 modifiers, change this to uint16 or uint32
-using TModifierStack = TArray<TModSize>;
+#include <type_traits>
+
+/**
+ * Default level width, used by the F-prefixed aliases below
+ * UINT8_MAX is NO_MODIFIER, so UINT8_MAX-1 is the max for uint8 -- NO_MODIFIER is defined in ModifierTypes.h
+ * If a modifier type needs more than 254 levels, use the T-prefixed templates with uint16 for that type only
+ */
+using TModSize = uint8;
+
+/** The level widths a modifier channel can use, a component keeps the channels of each width together */
+enum class EModifierLevelWidth : uint8
+{
+	/** uint8 levels, up to 254 */
+	Narrow,
+
+	/** uint16 levels, up to 65534 */
+	Wide,
+};
+
+/**
+ * Properties of a modifier level width
+ * Every level width reserves its max value as the sentinel for no modifier
+ */
+template<typename TLevel>
+struct TModifierLevelTraits
+{
+	static_assert(std::is_unsigned_v<TLevel>, "Modifier levels must be unsigned integers");
+	static_assert(sizeof(TLevel) <= 2, "Modifier levels wider than 16 bits are not supported, level sums are 32 bits");
+
+	/** Sentinel for no modifier, equivalent to NO_MODIFIER for uint8 */
+	static constexpr TLevel None = TNumericLimits<TLevel>::Max();
+
+	/** Number of bits of a level in memory, the wire width comes from FModifierStackNetFormat */
+	static constexpr int32 NumBits = sizeof(TLevel) * 8;
+
+	/** Narrow levels use a histogram indexed by level, wider levels use a sorted list of the levels in the stack */
+	static constexpr bool bDenseCounts = sizeof(TLevel) == 1;
+
+	/** The registry of a component the channels of this width are registered into */
+	static constexpr EModifierLevelWidth Width = sizeof(TLevel) == 1 ? EModifierLevelWidth::Narrow : EModifierLevelWidth::Wide;
+};
+
+/**
+ * Compile-time capacity of a single modifier stack, must be a power of two
+ * Stacks are stored inline, so saved moves, network moves and corrections never touch the heap
+ * MaxHastes, MaxSlows and MaxSlowFalls are clamped to this value
+ */
+#ifndef CM_MAX_MODIFIER_STACK
+#define CM_MAX_MODIFIER_STACK 32
+#endif
+
+template<typename TLevel>
+using TModifierLevelStack = TModifierRingStack<TLevel, CM_MAX_MODIFIER_STACK>;
+
+template<typename TLevel>
+using TModifierLevelStackView = TModifierRingStackView<TLevel, CM_MAX_MODIFIER_STACK>;
+
+using TModifierStack = TModifierLevelStack<TModSize>;
+using TModifierStackView = TModifierLevelStackView<TModSize>;
+
+/**
+ * Bit widths of a modifier stack on the wire
+ * Derived from the channel config (level tags, max modifiers) on both ends, so client and server agree without sending it
+ * The count takes ceil(log2(MaxModifiers + 1)) bits and each level ceil(log2(NumLevels)) bits, e.g. 2 bits for 4 levels
+ */
+struct FModifierStackNetFormat
+{
+	FModifierStackNetFormat(int32 InMaxModifiers, int32 InNumLevels)
+		: MaxModifiers(static_cast<uint8>(FMath::Clamp(InMaxModifiers, 0, CM_MAX_MODIFIER_STACK)))
+		, NumLevels(FMath::Max(InNumLevels, 0))
+		, CountBits(static_cast<uint8>(FMath::CeilLogTwo(static_cast<uint32>(MaxModifiers) + 1)))
+		, LevelBits(static_cast<uint8>(FMath::CeilLogTwo(static_cast<uint32>(NumLevels))))
+	{}
+
+	/** The most elements serialized, the newest are kept */
+	uint8 MaxModifiers;
+
+	/** Number of valid levels, levels at or above this fail serialization */
+	int32 NumLevels;
+
+	uint8 CountBits;
+	uint8 LevelBits;
+};
 
 /**
  * FSavedMove_Character
  */
-struct CUSTOMMOVEMENT_API FModifierSavedMove
+template<typename TLevel>
+struct TModifierSavedMove
 {
-	TModifierStack WantsModifiers;
+	TModifierLevelStack<TLevel> WantsModifiers;
 
-	FModifierSavedMove()
+	TModifierSavedMove()
 	{}
 	
-	virtual ~FModifierSavedMove() = default;
+	virtual ~TModifierSavedMove() = default;
 
 	virtual void Clear()
 	{
 		WantsModifiers.Empty();
 	}
 
-	void SetMoveFor(const TModifierStack& Modifiers)
+	void SetMoveFor(const TModifierLevelStack<TLevel>& Modifiers)
 	{
 		WantsModifiers = Modifiers;
 	}
 
-	bool CanCombineWith(const TModifierStack& Modifiers) const
+	bool CanCombineWith(const TModifierLevelStack<TLevel>& Modifiers) const
 	{
 		return WantsModifiers == Modifiers;
 	}
 
-	void SetInitialPosition(const TModifierStack& Modifiers)
+	void SetInitialPosition(const TModifierLevelStack<TLevel>& Modifiers)
 	{
 		WantsModifiers = Modifiers;
 	}
 
-	bool IsImportantMove(const TModifierStack& Modifiers) const
+	bool IsImportantMove(const TModifierLevelStack<TLevel>& Modifiers) const
 	{
 		return WantsModifiers != Modifiers;
 	}
 };
 
+using FModifierSavedMove = TModifierSavedMove<TModSize>;
+
 /**
  * FSavedMove_Character
  */
-struct CUSTOMMOVEMENT_API FModifierSavedMove_WithCorrection final : FModifierSavedMove
+template<typename TLevel>
+struct TModifierSavedMove_WithCorrection final : TModifierSavedMove<TLevel>
 {
-	using Super = FModifierSavedMove;
+	using Super = TModifierSavedMove<TLevel>;
 	
-	TModifierStack Modifiers;
+	TModifierLevelStack<TLevel> Modifiers;
 
-	FModifierSavedMove_WithCorrection()
+	TModifierSavedMove_WithCorrection()
 	{}
 
 	virtual void Clear() override
@@ -64,20 +149,23 @@ struct CUSTOMMOVEMENT_API FModifierSavedMove_WithCorrection final : FModifierSav
 		Modifiers.Empty();
 	}
 
-	void PostUpdate(const TModifierStack& InModifiers)
+	void PostUpdate(const TModifierLevelStack<TLevel>& InModifiers)
 	{
 		Modifiers = InModifiers;
 	}
 };
 
+using FModifierSavedMove_WithCorrection = TModifierSavedMove_WithCorrection<TModSize>;
+
 /**
  * FSavedMove_Character
  */
-struct CUSTOMMOVEMENT_API FModifierSavedMove_ServerInitiated
+template<typename TLevel>
+struct TModifierSavedMove_ServerInitiated
 {
-	TModifierStack Modifiers;
+	TModifierLevelStack<TLevel> Modifiers;
 
-	FModifierSavedMove_ServerInitiated()
+	TModifierSavedMove_ServerInitiated()
 	{}
 
 	void Clear()
@@ -85,107 +173,383 @@ struct CUSTOMMOVEMENT_API FModifierSavedMove_ServerInitiated
 		Modifiers.Empty();
 	}
 
-	void PostUpdate(const TModifierStack& InModifiers)
+	void PostUpdate(const TModifierLevelStack<TLevel>& InModifiers)
 	{
 		Modifiers = InModifiers;
 	}
 };
 
+using FModifierSavedMove_ServerInitiated = TModifierSavedMove_ServerInitiated<TModSize>;
+
 /**
  * FCharacterMoveResponseDataContainer
  * Only required when using WithCorrection or ServerInitiated modifiers
  */
-struct CUSTOMMOVEMENT_API FModifierMoveResponse
+template<typename TLevel>
+struct TModifierMoveResponse
 {
-	TModifierStack Modifiers;
+	TModifierLevelStack<TLevel> Modifiers;
 
-	void ServerFillResponseData(const TModifierStack& InModifiers)
+	void ServerFillResponseData(const TModifierLevelStack<TLevel>& InModifiers)
 	{
 		Modifiers = InModifiers;
 	}
 };
 
+using FModifierMoveResponse = TModifierMoveResponse<TModSize>;
+
 /**
  * FCharacterNetworkMoveData
  * Sends wanted modifiers (via input) to the server to be applied to the character
  */
-struct CUSTOMMOVEMENT_API FModifierMoveData_LocalPredicted
+template<typename TLevel>
+struct TModifierMoveData_LocalPredicted
 {
-	FModifierMoveData_LocalPredicted()
+	TModifierMoveData_LocalPredicted()
 	{}
 	
-	TModifierStack WantsModifiers;
+	TModifierLevelStack<TLevel> WantsModifiers;
 
-	void ClientFillNetworkMoveData(const TModifierStack& InWantsModifiers)
+	void ClientFillNetworkMoveData(const TModifierLevelStack<TLevel>& InWantsModifiers)
 	{
 		WantsModifiers = InWantsModifiers;
 	}
 
-	bool Serialize(FArchive& Ar, const FString& ErrorName, uint8 MaxSerializedModifiers=8);
+	bool IsEmpty() const { return WantsModifiers.IsEmpty(); }
+	void Reset() { WantsModifiers.Reset(); }
+
+	bool Serialize(FArchive& Ar, const FString& ErrorName, const FModifierStackNetFormat& WantsFormat);
 };
 
+using FModifierMoveData_LocalPredicted = TModifierMoveData_LocalPredicted<TModSize>;
+
 /**
  * FCharacterNetworkMoveData
  * Sends wanted modifiers (via input) to the server to be applied to the character
  * Server compares the client and server modifiers to know when to send a net correction to the client with updated modifiers
  */
-struct CUSTOMMOVEMENT_API FModifierMoveData_WithCorrection
+template<typename TLevel>
+struct TModifierMoveData_WithCorrection
 {
-	FModifierMoveData_WithCorrection()
+	TModifierMoveData_WithCorrection()
 	{}
 
-	TModifierStack WantsModifiers;
-	TModifierStack Modifiers;
+	TModifierLevelStack<TLevel> WantsModifiers;
+	TModifierLevelStack<TLevel> Modifiers;
 
-	void ClientFillNetworkMoveData(const TModifierStack& InWantsModifiers, const TModifierStack& InModifiers)
+	void ClientFillNetworkMoveData(const TModifierLevelStack<TLevel>& InWantsModifiers, const TModifierLevelStack<TLevel>& InModifiers)
 	{
 		WantsModifiers = InWantsModifiers;
 		Modifiers = InModifiers;
 	}
 
-	bool Serialize(FArchive& Ar, const FString& ErrorName, uint8 MaxSerializedModifiers=8);
+	bool IsEmpty() const { return WantsModifiers.IsEmpty() && Modifiers.IsEmpty(); }
+	void Reset() { WantsModifiers.Reset(); Modifiers.Reset(); }
+
+	bool Serialize(FArchive& Ar, const FString& ErrorName, const FModifierStackNetFormat& WantsFormat, const FModifierStackNetFormat& Format);
 };
 
+using FModifierMoveData_WithCorrection = TModifierMoveData_WithCorrection<TModSize>;
+
 /**
  * FCharacterNetworkMoveData
  * Used by server to compare between client and server, to know when to send a net correction to the client with updated modifiers
  */
-struct CUSTOMMOVEMENT_API FModifierMoveData_ServerInitiated
+template<typename TLevel>
+struct TModifierMoveData_ServerInitiated
 {
-	FModifierMoveData_ServerInitiated()
+	TModifierMoveData_ServerInitiated()
 	{}
 	
-	TModifierStack Modifiers;
+	TModifierLevelStack<TLevel> Modifiers;
 
-	void ClientFillNetworkMoveData(const TModifierStack& InModifiers)
+	void ClientFillNetworkMoveData(const TModifierLevelStack<TLevel>& InModifiers)
 	{
 		Modifiers = InModifiers;
 	}
 
-	bool Serialize(FArchive& Ar, const FString& ErrorName, uint8 MaxSerializedModifiers=8);
+	bool Serialize(FArchive& Ar, const FString& ErrorName, const FModifierStackNetFormat& Format);
 };
 
+using FModifierMoveData_ServerInitiated = TModifierMoveData_ServerInitiated<TModSize>;
+
+/**
+ * Histogram of a modifier stack: a count per level, plus the running sum, min and max
+ * Makes level counts and every EModifierLevelMethod result O(1), while the stack itself keeps insertion order
+ * Specialized below for narrow (dense table indexed by level) and wide (sorted list of distinct levels) level widths
+ */
+template<typename TLevel, bool bDense = TModifierLevelTraits<TLevel>::bDenseCounts>
+struct TModifierLevelCounts;
+
+/**
+ * Dense histogram, a count per possible level
+ */
+template<typename TLevel>
+struct TModifierLevelCounts<TLevel, true>
+{
+	static constexpr int32 NumLevels = TNumericLimits<TLevel>::Max() + 1;
+	static constexpr int32 NumWords = (NumLevels + 63) / 64;
+
+	TModifierLevelCounts()
+	{
+		Reset();
+	}
+
+	/** Number of modifiers in the stack */
+	int32 Num() const { return NumModifiers; }
+	bool IsEmpty() const { return NumModifiers == 0; }
+
+	/** Sum of all levels in the stack */
+	uint32 GetSum() const { return Sum; }
+
+	/** Number of modifiers with the specified level */
+	uint8 GetCount(TLevel Level) const { return Counts[Level]; }
+
+	/** Lowest level in the stack, only valid if not empty */
+	TLevel GetMin() const
+	{
+		for (int32 Word = 0; Word < NumWords; ++Word)
+		{
+			if (Occupied[Word] != 0)
+			{
+				return static_cast<TLevel>(Word * 64 + FMath::CountTrailingZeros64(Occupied[Word]));
+			}
+		}
+		return 0;
+	}
+
+	/** Highest level in the stack, only valid if not empty */
+	TLevel GetMax() const
+	{
+		for (int32 Word = NumWords - 1; Word >= 0; --Word)
+		{
+			if (Occupied[Word] != 0)
+			{
+				return static_cast<TLevel>(Word * 64 + 63 - FMath::CountLeadingZeros64(Occupied[Word]));
+			}
+		}
+		return 0;
+	}
+
+	void Add(TLevel Level)
+	{
+		if (Counts[Level]++ == 0)
+		{
+			Occupied[Level / 64] |= 1ull << (Level % 64);
+		}
+		Sum += Level;
+		NumModifiers++;
+	}
+
+	void Remove(TLevel Level, int32 Count = 1)
+	{
+		Count = FMath::Min<int32>(Count, Counts[Level]);
+		Counts[Level] -= Count;
+		if (Counts[Level] == 0)
+		{
+			Occupied[Level / 64] &= ~(1ull << (Level % 64));
+		}
+		Sum -= Level * Count;
+		NumModifiers -= Count;
+	}
+
+	void Reset()
+	{
+		FMemory::Memzero(Counts);
+		FMemory::Memzero(Occupied);
+		Sum = 0;
+		NumModifiers = 0;
+	}
+
+	/** Recount the histogram from a stack, used when the stack is replaced wholesale */
+	void Rebuild(const TModifierLevelStack<TLevel>& Modifiers)
+	{
+		Reset();
+		for (const TLevel Level : Modifiers)
+		{
+			Add(Level);
+		}
+	}
+
+private:
+	uint8 Counts[NumLevels];
+	uint64 Occupied[NumWords];
+	uint32 Sum;
+	int32 NumModifiers;
+};
+
+/**
+ * Sparse histogram, the distinct levels in the stack kept in ascending order with a count each
+ * A stack never holds more than CM_MAX_MODIFIER_STACK distinct levels, so this stays small however wide the level is
+ */
+template<typename TLevel>
+struct TModifierLevelCounts<TLevel, false>
+{
+	static constexpr int32 MaxDistinct = CM_MAX_MODIFIER_STACK;
+
+	TModifierLevelCounts()
+	{
+		Reset();
+	}
+
+	/** Number of modifiers in the stack */
+	int32 Num() const { return NumModifiers; }
+	bool IsEmpty() const { return NumModifiers == 0; }
+
+	/** Sum of all levels in the stack */
+	uint32 GetSum() const { return Sum; }
+
+	/** Number of modifiers with the specified level */
+	uint8 GetCount(TLevel Level) const
+	{
+		const int32 Index = LowerBound(Level);
+		return Index < NumDistinct && Levels[Index] == Level ? Counts[Index] : 0;
+	}
+
+	/** Lowest level in the stack, only valid if not empty */
+	TLevel GetMin() const { return NumDistinct > 0 ? Levels[0] : 0; }
+
+	/** Highest level in the stack, only valid if not empty */
+	TLevel GetMax() const { return NumDistinct > 0 ? Levels[NumDistinct - 1] : 0; }
+
+	void Add(TLevel Level)
+	{
+		const int32 Index = LowerBound(Level);
+		if (Index < NumDistinct && Levels[Index] == Level)
+		{
+			Counts[Index]++;
+		}
+		else if (ensureMsgf(NumDistinct < MaxDistinct, TEXT("More distinct modifier levels than the stack can hold")))
+		{
+			for (int32 i = NumDistinct; i > Index; --i)
+			{
+				Levels[i] = Levels[i - 1];
+				Counts[i] = Counts[i - 1];
+			}
+			Levels[Index] = Level;
+			Counts[Index] = 1;
+			NumDistinct++;
+		}
+		else
+		{
+			return;
+		}
+		Sum += Level;
+		NumModifiers++;
+	}
+
+	void Remove(TLevel Level, int32 Count = 1)
+	{
+		const int32 Index = LowerBound(Level);
+		if (Index >= NumDistinct || Levels[Index] != Level)
+		{
+			return;
+		}
+
+		Count = FMath::Min<int32>(Count, Counts[Index]);
+		Counts[Index] -= Count;
+		if (Counts[Index] == 0)
+		{
+			for (int32 i = Index; i < NumDistinct - 1; ++i)
+			{
+				Levels[i] = Levels[i + 1];
+				Counts[i] = Counts[i + 1];
+			}
+			NumDistinct--;
+		}
+		Sum -= Level * Count;
+		NumModifiers -= Count;
+	}
+
+	void Reset()
+	{
+		NumDistinct = 0;
+		Sum = 0;
+		NumModifiers = 0;
+	}
+
+	/** Recount the histogram from a stack, used when the stack is replaced wholesale */
+	void Rebuild(const TModifierLevelStack<TLevel>& Modifiers)
+	{
+		Reset();
+		for (const TLevel Level : Modifiers)
+		{
+			Add(Level);
+		}
+	}
+
+private:
+	/** Index of the first distinct level that is not less than Level */
+	int32 LowerBound(TLevel Level) const
+	{
+		int32 Min = 0;
+		int32 Max = NumDistinct;
+		while (Min < Max)
+		{
+			const int32 Mid = (Min + Max) / 2;
+			if (Levels[Mid] < Level)
+			{
+				Min = Mid + 1;
+			}
+			else
+			{
+				Max = Mid;
+			}
+		}
+		return Min;
+	}
+
+	TLevel Levels[MaxDistinct];
+	uint8 Counts[MaxDistinct];
+	int32 NumDistinct;
+	uint32 Sum;
+	int32 NumModifiers;
+};
+
+using FModifierLevelCounts = TModifierLevelCounts<TModSize>;
+
 /**
  * Represents a single modifier that can be applied to a character
  * This is the base class for all modifiers, which can be local predicted, with correction, or server initiated
  */
-struct CUSTOMMOVEMENT_API FMovementModifier
+template<typename TLevel>
+struct TMovementModifier
 {
-	/** The requested input state, which requests modifiers of the specified level */
-	TModifierStack WantsModifiers;
+	/**
+	 * The requested input state, which requests modifiers of the specified level
+	 * Modify via AddModifier, RemoveModifier, ResetModifiers or SetWantsModifiers to keep WantsCounts in sync
+	 */
+	TModifierLevelStack<TLevel> WantsModifiers;
 	
 	/** The actual state, which represents the actual modifiers applied to the character */
-	TModifierStack Modifiers;
+	TModifierLevelStack<TLevel> Modifiers;
+
+	/** Histogram of WantsModifiers */
+	TModifierLevelCounts<TLevel> WantsCounts;
+
+	/** Histogram of Modifiers */
+	TModifierLevelCounts<TLevel> ModifierCounts;
+
+	/** Changes whenever WantsModifiers is edited, used to skip processing when nothing changed */
+	uint32 WantsGeneration = 0;
 	
 	/**
 	 * Adds a modifier to the stack
+	 * The modifier is always added, if the stack is full the oldest modifier is evicted to make room, as limiting keeps the newest
 	 * @param Level The level of the modifier to add
-	 * @return True if the modifier was added
+	 * @return False if the stack was full and the oldest modifier was evicted, callers report it with the name of the modifier
 	 */
-	bool AddModifier(TModSize Level)
+	bool AddModifier(TLevel Level)
 	{
-		WantsModifiers.Add(Level);
-		return true;
+		TLevel Evicted = 0;
+		const bool bEvicted = WantsModifiers.Add(Level, &Evicted);
+		if (bEvicted)
+		{
+			WantsCounts.Remove(Evicted);
+		}
+		WantsCounts.Add(Level);
+		WantsGeneration++;
+		return !bEvicted;
 	}
 
 	/**
@@ -194,18 +558,19 @@ struct CUSTOMMOVEMENT_API FMovementModifier
 	 * @param bRemoveAll If true, removes all modifiers of the specified level, otherwise removes only one
 	 * @return True if the modifier was removed, false otherwise
 	 */
-	bool RemoveModifier(TModSize Level, bool bRemoveAll)
+	bool RemoveModifier(TLevel Level, bool bRemoveAll)
 	{
-		if (WantsModifiers.Contains(Level))
+		if (WantsCounts.GetCount(Level) > 0)
 		{
 			if (bRemoveAll)
 			{
-				WantsModifiers.Remove(Level);
+				WantsCounts.Remove(Level, WantsModifiers.Remove(Level));
 			}
 			else
 			{
-				WantsModifiers.RemoveSingle(Level);
+				WantsCounts.Remove(Level, WantsModifiers.RemoveSingle(Level));
 			}
+			WantsGeneration++;
 			return true;
 		}
 		return false;
@@ -220,6 +585,24 @@ struct CUSTOMMOVEMENT_API FMovementModifier
 		if (WantsModifiers.Num() > 0)
 		{
 			WantsModifiers.Reset();
+			WantsCounts.Reset();
+			WantsGeneration++;
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * Replaces the wanted modifiers, e.g. from a saved move, network move or correction
+	 * @return True if the wanted modifiers changed
+	 */
+	bool SetWantsModifiers(const TModifierLevelStack<TLevel>& InWantsModifiers)
+	{
+		if (WantsModifiers != InWantsModifiers)
+		{
+			WantsModifiers = InWantsModifiers;
+			WantsCounts.Rebuild(WantsModifiers);
+			WantsGeneration++;
 			return true;
 		}
 		return false;
@@ -231,7 +614,7 @@ struct CUSTOMMOVEMENT_API FMovementModifier
 	 * @param Level The level to filter by
 	 * @return The number of modifiers that match the specified level
 	 */
-	TModSize GetNumWantedModifiersByLevel(TModSize Level) const;
+	uint8 GetNumWantedModifiersByLevel(TLevel Level) const;
 
 	/**
 	 * Returns the number of modifiers in the stack that match the specified level
@@ -239,39 +622,50 @@ struct CUSTOMMOVEMENT_API FMovementModifier
 	 * @param Level The level to filter by
 	 * @return The number of modifiers that match the specified level
 	 */
-	TModSize GetNumModifiersByLevel(TModSize Level) const;
+	uint8 GetNumModifiersByLevel(TLevel Level) const;
 
 	/**
 	 * Limits the number of modifiers in the stack to the specified maximum
 	 * Supports limiting between different types of modifiers affecting the same type of movement, e.g. BoostLocal and BoostCorrection
 	 */
-	static void LimitNumModifiers(TModifierStack& Modifiers, int32& RemainingModifiers);
+	static void LimitNumModifiers(TModifierLevelStack<TLevel>& Modifiers, int32& RemainingModifiers);
+
+	/**
+	 * Returns how many of the newest modifiers are kept when limiting a stack of NumModifiers, and consumes them from RemainingModifiers
+	 * @see LimitNumModifiers
+	 */
+	static int32 GetNumLimitedModifiers(int32 NumModifiers, int32& RemainingModifiers);
 
 	/** Applies WantsModifiers to Modifiers based on the current state of the character */
 	bool UpdateMovementState(bool bAllowedInCurrentState, bool bClampMax, int32& Remaining);
 };
 
+using FMovementModifier = TMovementModifier<TModSize>;
+
 /**
  * Represents a single modifier that can be applied to a character
  * Local Predicted modifier is activated via player input and is predicted on the client
  * e.g. Sprint, Crouch, etc.
  */
-struct CUSTOMMOVEMENT_API FMovementModifier_LocalPredicted : FMovementModifier
+template<typename TLevel>
+struct TMovementModifier_LocalPredicted : TMovementModifier<TLevel>
 {
-	FMovementModifier_LocalPredicted()
+	TMovementModifier_LocalPredicted()
 	{}
 
-	void ServerMove_PerformMovement(const TModifierStack& InWantsModifiers)
+	void ServerMove_PerformMovement(const TModifierLevelStack<TLevel>& InWantsModifiers)
 	{
-		WantsModifiers = InWantsModifiers;
+		this->SetWantsModifiers(InWantsModifiers);
 	}
 
-	void CombineWith(const TModifierStack& InWantsModifiers)
+	void CombineWith(const TModifierLevelStack<TLevel>& InWantsModifiers)
 	{
-		WantsModifiers = InWantsModifiers;
+		this->SetWantsModifiers(InWantsModifiers);
 	}
 };
 
+using FMovementModifier_LocalPredicted = TMovementModifier_LocalPredicted<TModSize>;
+
 /**
  * Represents a single modifier that can be applied to a character
  * 
@@ -282,33 +676,248 @@ struct CUSTOMMOVEMENT_API FMovementModifier_LocalPredicted : FMovementModifier
  * 
  * e.g. Speed increase after equipping a knife via predicted inventory ability, etc.
  */
-struct CUSTOMMOVEMENT_API FMovementModifier_WithCorrection final : FMovementModifier_LocalPredicted
+template<typename TLevel>
+struct TMovementModifier_WithCorrection final : TMovementModifier_LocalPredicted<TLevel>
+{
+	bool ServerCheckClientError(const TModifierLevelStack<TLevel>& InModifiers) const
+	{
+		return this->Modifiers != InModifiers;
+	}
+
+	void OnClientCorrectionReceived(const TModifierLevelStack<TLevel>& InModifiers)
+	{
+		this->SetWantsModifiers(InModifiers);
+	}
+};
+
+using FMovementModifier_WithCorrection = TMovementModifier_WithCorrection<TModSize>;
+
+/**
+ * Represents a single modifier that can be applied to a character
+ * 
+ * Server Initiated modifier is applied by the server and pushed to the client when it changes
+ * It is not predicted, and the client never sends it back to the server
+ * 
+ * e.g. Snared from a damage event on the server
+ */
+template<typename TLevel>
+struct TMovementModifier_ServerInitiated final : TMovementModifier<TLevel>
+{
+	void OnServerModifiersReceived(const TModifierLevelStack<TLevel>& InWantsModifiers)
+	{
+		this->SetWantsModifiers(InWantsModifiers);
+	}
+};
+
+using FMovementModifier_ServerInitiated = TMovementModifier_ServerInitiated<TModSize>;
+
+/**
+ * Represents a single modifier that can be applied to a character
+ * 
+ * Scheduled modifier is applied by the server on a future client move, and the schedule is sent to the client ahead of time
+ * Both apply it on the same simulated move, so unlike a server initiated modifier it does not cause a correction
+ * 
+ * e.g. Snared by an ability that can afford a short delay
+ */
+template<typename TLevel>
+struct TMovementModifier_Scheduled final : TMovementModifier<TLevel>
+{};
+
+using FMovementModifier_Scheduled = TMovementModifier_Scheduled<TModSize>;
+
+/**
+ * Reduction kernel for a single EModifierLevelMethod
+ * Resolved once per modifier type via FModifierStatics::GetLevelKernel and kept in its process cache, instead of branching on the method per stack
+ */
+template<typename TLevel>
+struct TModifierLevelKernel
+{
+	/** Reduces a stack of levels to a single level, or InvalidLevel if the stack is empty */
+	TLevel (*ReduceStack)(const TModifierLevelStack<TLevel>& Levels, TLevel MaxLevel, TLevel InvalidLevel);
+
+	/** Reduces the histogram of a stack to a single level in O(1), or InvalidLevel if the stack is empty */
+	TLevel (*ReduceCounts)(const TModifierLevelCounts<TLevel>& Counts, TLevel MaxLevel, TLevel InvalidLevel);
+};
+
+using FModifierLevelKernel = TModifierLevelKernel<TModSize>;
+
+/**
+ * Result of the last FModifierStatics::ProcessModifiers call for a modifier type (e.g. Haste)
+ * When no modifier was edited and the inputs are the same, processing skips straight to the cached level
+ */
+template<typename TLevel>
+struct TModifierProcessCache
+{
+	/** Sum of the WantsGeneration of every processed modifier */
+	uint32 Generation = 0;
+
+	/* The method, limits and highest level the cached level was computed with */
+
+	int32 MaxModifiers = 0;
+	EModifierLevelMethod Method = EModifierLevelMethod::Max;
+	bool bLimitMaxModifiers = false;
+	TLevel MaxLevel = 0;
+
+	/** The cached result of the activation callback */
+	bool bCanActivate = false;
+
+	/** Whether the cache holds a result at all */
+	bool bValid = false;
+
+	/** The cached combined level */
+	TLevel Level = TModifierLevelTraits<TLevel>::None;
+
+	/** The kernel of KernelMethod, resolved when the modifier type is registered and again only when its method changes */
+	const TModifierLevelKernel<TLevel>* Kernel = nullptr;
+	EModifierLevelMethod KernelMethod = EModifierLevelMethod::Max;
+
+	/** Forces the next ProcessModifiers call to run the full pipeline, the kernel is kept */
+	void Invalidate() { bValid = false; }
+};
+
+using FModifierProcessCache = TModifierProcessCache<TModSize>;
+
+/**
+ * Hash index from level tag to level, i.e. the index of the tag in the level tags of a modifier type
+ * Must be rebuilt whenever the level tags change
+ */
+template<typename TLevel>
+struct TModifierLevelIndex
+{
+	/** Indexes the level tags, the first occurrence of a tag wins and tags that don't fit the level width are skipped */
+	void Rebuild(const TArray<FGameplayTag>& LevelTags)
+	{
+		const int32 NumLevels = FMath::Min<int32>(LevelTags.Num(), TModifierLevelTraits<TLevel>::None);
+		TagToLevel.Reset();
+		TagToLevel.Reserve(NumLevels);
+		for (int32 Level = 0; Level < NumLevels; ++Level)
+		{
+			if (!TagToLevel.Contains(LevelTags[Level]))
+			{
+				TagToLevel.Add(LevelTags[Level], static_cast<TLevel>(Level));
+			}
+		}
+	}
+
+	void Reset()
+	{
+		TagToLevel.Reset();
+	}
+
+	bool Contains(const FGameplayTag& Tag) const { return TagToLevel.Contains(Tag); }
+
+	/** The level of the tag, or the no-modifier sentinel if the tag is not a level */
+	TLevel Find(const FGameplayTag& Tag) const
+	{
+		const TLevel* Level = TagToLevel.Find(Tag);
+		return Level ? *Level : TModifierLevelTraits<TLevel>::None;
+	}
+
+private:
+	TMap<FGameplayTag, TLevel> TagToLevel;
+};
+
+/**
+ * Params of a modifier type indexed by level, aligned with the level tags of that type
+ * Resolving the params of the active level is a bounds-checked array index instead of a map lookup by tag
+ * Must be rebuilt whenever the level tags or the params map change
+ */
+template<typename TParams>
+struct TModifierParamsTable
 {
-	bool ServerCheckClientError(const TModifierStack& InModifiers) const
+	/**
+	 * Copies the params of each level tag out of the map, levels without params resolve to nullptr
+	 * The copies bake their curves, so curve driven params are only evaluated from lookup tables
+	 */
+	void Rebuild(const TArray<FGameplayTag>& LevelTags, const TMap<FGameplayTag, TParams>& ParamsMap)
+	{
+		Params.Reset(LevelTags.Num());
+		bHasParams.Init(false, LevelTags.Num());
+		for (int32 Level = 0; Level < LevelTags.Num(); ++Level)
+		{
+			if (const TParams* LevelParams = ParamsMap.Find(LevelTags[Level]))
+			{
+				Params.Add(*LevelParams);
+				Params.Last().BakeCurves();
+				bHasParams[Level] = true;
+			}
+			else
+			{
+				Params.AddDefaulted();
+			}
+		}
+	}
+
+	void Reset()
 	{
-		return Modifiers != InModifiers;
+		Params.Reset();
+		bHasParams.Reset();
 	}
 
-	void OnClientCorrectionReceived(const TModifierStack& InModifiers)
+	int32 Num() const { return Params.Num(); }
+
+	/** The params of the level, or nullptr if the level is invalid or has no params */
+	template<typename TLevel>
+	const TParams* Find(TLevel Level) const
 	{
-		WantsModifiers = InModifiers;
+		return Params.IsValidIndex(Level) && bHasParams[Level] ? &Params[Level] : nullptr;
 	}
+
+private:
+	TArray<TParams> Params;
+	TBitArray<> bHasParams;
 };
 
 /**
  * Static functions for modifiers
+ * Templated on the level width, instantiated for uint8 and uint16 in ModifierImpl.cpp
  */
 struct CUSTOMMOVEMENT_API FModifierStatics
 {
 	/**
-	 * Serializes the modifier stack to the archive
+	 * Serializes the modifier stack to the archive, bit-packed to the widths of the format
 	 * @param Modifiers The modifier stack to serialize
 	 * @param Ar The archive to serialize to
 	 * @param ErrorName The name of the Modifier to report if serialization fails
-	 * @param MaxSerializedModifiers The maximum number of modifiers to serialize (default is 8)
+	 * @param Format The count and level widths, which must match on both ends
 	 * @return True if serialization was successful, false otherwise
 	 */
-	static bool NetSerialize(TModifierStack& Modifiers, FArchive& Ar, const FString& ErrorName, uint8 MaxSerializedModifiers=8);
+	template<typename TLevel>
+	static bool NetSerialize(TModifierLevelStack<TLevel>& Modifiers, FArchive& Ar, const FString& ErrorName, const FModifierStackNetFormat& Format);
+
+	/**
+	 * Serializes the modifier stack as edits to a baseline stack both ends have
+	 * A single bit while unchanged, otherwise the number of oldest elements dropped and newest elements popped from the baseline,
+	 * then the elements pushed, each at the widths of the format
+	 * @param Modifiers The modifier stack to serialize
+	 * @param Baseline The stack the edits apply to, null when loading without the baseline, to only consume the bits
+	 * @param Ar The archive to serialize to
+	 * @param ErrorName The name of the Modifier to report if serialization fails
+	 * @param Format The count and level widths, which must match on both ends
+	 * @return True if serialization was successful, false otherwise
+	 */
+	template<typename TLevel>
+	static bool NetSerializeDelta(TModifierLevelStack<TLevel>& Modifiers, const TModifierLevelStack<TLevel>* Baseline, FArchive& Ar,
+		const FString& ErrorName, const FModifierStackNetFormat& Format);
+
+	/**
+	 * Serializes a single level at the width of the format, e.g. a scheduled modifier
+	 * @param Level The level to serialize
+	 * @param Ar The archive to serialize to
+	 * @param ErrorName The name of the Modifier to report if serialization fails
+	 * @param Format The level width, which must match on both ends
+	 * @return True if serialization was successful, false if the level is not one the channel has
+	 */
+	template<typename TLevel>
+	static bool NetSerializeLevel(TLevel& Level, FArchive& Ar, const FString& ErrorName, const FModifierStackNetFormat& Format);
+
+	/**
+	 * Returns the reduction kernel for the specified method
+	 * @param Method The method to use for calculating modifier levels
+	 * @return The kernel, which returns the invalid level for unknown methods
+	 */
+	template<typename TLevel>
+	static const TModifierLevelKernel<TLevel>& GetLevelKernel(EModifierLevelMethod Method);
 
 	/**
 	 * Updates the modifier level based on the specified method
@@ -318,7 +927,19 @@ struct CUSTOMMOVEMENT_API FModifierStatics
 	 * @param InvalidLevel The level to return if no valid modifiers are found
 	 * @return The updated modifier level
 	 */
-	static TModSize UpdateModifierLevel(EModifierLevelMethod Method, const TModifierStack& Modifiers, TModSize MaxLevel, TModSize InvalidLevel);
+	template<typename TLevel>
+	static TLevel UpdateModifierLevel(EModifierLevelMethod Method, const TModifierLevelStack<TLevel>& Modifiers, TLevel MaxLevel, TLevel InvalidLevel);
+
+	/**
+	 * Updates the modifier level based on the specified method, in O(1) from the histogram of the stack
+	 * @param Method The method to use for updating the modifier level
+	 * @param Counts The histogram of the stack of modifiers to update
+	 * @param MaxLevel The maximum level of modifiers
+	 * @param InvalidLevel The level to return if no valid modifiers are found
+	 * @return The updated modifier level
+	 */
+	template<typename TLevel>
+	static TLevel UpdateModifierLevel(EModifierLevelMethod Method, const TModifierLevelCounts<TLevel>& Counts, TLevel MaxLevel, TLevel InvalidLevel);
 
 	/**
 	 * Combines multiple modifier levels into a single level based on the specified method
@@ -328,7 +949,8 @@ struct CUSTOMMOVEMENT_API FModifierStatics
 	 * @param InvalidLevel The level to return if no valid modifiers are found
 	 * @return The combined modifier level
 	 */
-	static TModSize CombineModifierLevels(EModifierLevelMethod Method, const TModifierStack& ModifierLevels, TModSize MaxLevel, TModSize InvalidLevel);
+	template<typename TLevel>
+	static TLevel CombineModifierLevels(EModifierLevelMethod Method, const TModifierLevelStack<TLevel>& ModifierLevels, TLevel MaxLevel, TLevel InvalidLevel);
 
 	/**
 	 * Processes modifiers based on the specified method and updates the current level
@@ -338,11 +960,25 @@ struct CUSTOMMOVEMENT_API FModifierStatics
 	 * @param bLimitMaxModifiers Whether to limit the maximum number of modifiers
 	 * @param MaxModifiers The maximum number of modifiers allowed
 	 * @param InvalidLevel The level to return if no valid modifiers are found
-	 * @param Modifiers The array of modifiers to process
+	 * @param Modifiers The modifiers to process, usually a view of a local array so processing doesn't allocate
 	 * @param CanActivateCallback Callback to determine if the modifier can be activated
+	 * @param Cache Result of the previous call, used to skip processing when nothing changed
 	 * @return True if the current level changed, false otherwise
 	 */
-	static bool ProcessModifiers(TModSize& CurrentLevel, EModifierLevelMethod Method, const TArray<FGameplayTag>& LevelTags,
-		bool bLimitMaxModifiers, int32 MaxModifiers, TModSize InvalidLevel,	const TArray<FMovementModifier*>& Modifiers,
-		const TFunctionRef<bool()>& CanActivateCallback);
-};
\ No newline at end of file
+	template<typename TLevel>
+	static bool ProcessModifiers(TLevel& CurrentLevel, EModifierLevelMethod Method, const TArray<FGameplayTag>& LevelTags,
+		bool bLimitMaxModifiers, int32 MaxModifiers, TLevel InvalidLevel, TArrayView<TMovementModifier<TLevel>* const> Modifiers,
+		const TFunctionRef<bool()>& CanActivateCallback, TModifierProcessCache<TLevel>& Cache);
+};
+
+/*
+ * Level widths with out-of-line members, instantiated in ModifierImpl.cpp
+ */
+extern template struct CUSTOMMOVEMENT_API TModifierMoveData_LocalPredicted<uint8>;
+extern template struct CUSTOMMOVEMENT_API TModifierMoveData_LocalPredicted<uint16>;
+extern template struct CUSTOMMOVEMENT_API TModifierMoveData_WithCorrection<uint8>;
+extern template struct CUSTOMMOVEMENT_API TModifierMoveData_WithCorrection<uint16>;
+extern template struct CUSTOMMOVEMENT_API TModifierMoveData_ServerInitiated<uint8>;
+extern template struct CUSTOMMOVEMENT_API TModifierMoveData_ServerInitiated<uint16>;
+extern template struct CUSTOMMOVEMENT_API TMovementModifier<uint8>;
+extern template struct CUSTOMMOVEMENT_API TMovementModifier<uint16>;
\ No newline at end of file
@@ -0,0 +1,342 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+
+template<typename ElementType, int32 Capacity>
+class TModifierRingStack;
+
+/**
+ * Read-only window over a contiguous (oldest to newest) range of a TModifierRingStack
+ * Used to produce clamped views of a stack without copying it
+ */
+template<typename ElementType, int32 Capacity>
+class TModifierRingStackView
+{
+public:
+	using StackType = TModifierRingStack<ElementType, Capacity>;
+
+	TModifierRingStackView(const StackType& InStack, int32 InStart, int32 InNum)
+		: Stack(&InStack)
+		, Start(InStart)
+		, NumElements(InNum)
+	{}
+
+	int32 Num() const { return NumElements; }
+	bool IsEmpty() const { return NumElements == 0; }
+
+	/** Element at the logical index, where 0 is the oldest element of the view */
+	ElementType operator[](int32 Index) const
+	{
+		checkSlow(Index >= 0 && Index < NumElements);
+		return (*Stack)[Start + Index];
+	}
+
+private:
+	const StackType* Stack;
+	int32 Start;
+	int32 NumElements;
+};
+
+/**
+ * Fixed-capacity stack of modifier levels, stored inline as a ring buffer
+ *
+ * Elements are always exposed from oldest to newest, so equality and serialization see the same order on every machine
+ * Evicting the oldest entries only advances the head index, and pushing onto a full stack evicts the oldest entry
+ *
+ * Keeps an order dependent fingerprint of its elements, updated as it is modified, so comparing two stacks
+ * (saved move combining, important moves, server error checks) usually costs one 64-bit compare
+ * Elements are read-only from outside, so every modification goes through the fingerprint
+ */
+template<typename ElementType, int32 Capacity>
+class TModifierRingStack
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "TModifierRingStack capacity must be a power of two");
+	static_assert(Capacity <= 128, "TModifierRingStack capacity must fit the uint8 head and count");
+
+public:
+	using ViewType = TModifierRingStackView<ElementType, Capacity>;
+
+	TModifierRingStack()
+		: Fingerprint(0)
+		, Head(0)
+		, NumElements(0)
+	{
+		FMemory::Memzero(Data);
+	}
+
+	static constexpr int32 Max() { return Capacity; }
+
+	int32 Num() const { return NumElements; }
+	bool IsEmpty() const { return NumElements == 0; }
+	bool IsFull() const { return NumElements == Capacity; }
+
+	/** Element at the logical index, where 0 is the oldest element */
+	ElementType operator[](int32 Index) const
+	{
+		checkSlow(Index >= 0 && Index < NumElements);
+		return Data[(Head + Index) & Mask];
+	}
+
+	/**
+	 * Pushes a new element, evicting the oldest element if the stack is full
+	 * @param OutEvicted Receives the evicted element, if any
+	 * @return True if an element was evicted to make room
+	 */
+	bool Add(ElementType Element, ElementType* OutEvicted = nullptr)
+	{
+		if (IsFull())
+		{
+			if (OutEvicted)
+			{
+				*OutEvicted = Data[Head];
+			}
+			Fingerprint -= HashElement(Data[Head]) * Powers.Values[Capacity - 1];
+			Fingerprint = Fingerprint * FingerprintBase + HashElement(Element);
+			Data[Head] = Element;
+			Head = static_cast<uint8>((Head + 1) & Mask);
+			return true;
+		}
+		Fingerprint = Fingerprint * FingerprintBase + HashElement(Element);
+		Data[(Head + NumElements) & Mask] = Element;
+		NumElements++;
+		return false;
+	}
+
+	bool Contains(ElementType Element) const
+	{
+		for (int32 i = 0; i < NumElements; ++i)
+		{
+			if ((*this)[i] == Element)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Removes every element equal to Element, preserving the order of the remaining elements
+	 * @return The number of elements removed
+	 */
+	int32 Remove(ElementType Element)
+	{
+		int32 Write = 0;
+		for (int32 Read = 0; Read < NumElements; ++Read)
+		{
+			const ElementType Value = (*this)[Read];
+			if (Value != Element)
+			{
+				At(Write++) = Value;
+			}
+		}
+		const int32 NumRemoved = NumElements - Write;
+		NumElements = static_cast<uint8>(Write);
+		if (NumRemoved > 0)
+		{
+			RebuildFingerprint();
+		}
+		return NumRemoved;
+	}
+
+	/**
+	 * Removes the oldest element equal to Element, preserving the order of the remaining elements
+	 * @return The number of elements removed (0 or 1)
+	 */
+	int32 RemoveSingle(ElementType Element)
+	{
+		for (int32 i = 0; i < NumElements; ++i)
+		{
+			if ((*this)[i] == Element)
+			{
+				for (int32 j = i; j < NumElements - 1; ++j)
+				{
+					At(j) = At(j + 1);
+				}
+				NumElements--;
+				RebuildFingerprint();
+				return 1;
+			}
+		}
+		return 0;
+	}
+
+	/** Evicts the oldest Count elements by advancing the head */
+	void RemoveOldest(int32 Count)
+	{
+		Count = FMath::Clamp(Count, 0, static_cast<int32>(NumElements));
+		for (int32 i = 0; i < Count; ++i)
+		{
+			Fingerprint -= HashElement(At(i)) * Powers.Values[NumElements - 1 - i];
+		}
+		Head = static_cast<uint8>((Head + Count) & Mask);
+		NumElements = static_cast<uint8>(NumElements - Count);
+	}
+
+	void Reset()
+	{
+		Fingerprint = 0;
+		Head = 0;
+		NumElements = 0;
+	}
+
+	void Empty()
+	{
+		Reset();
+	}
+
+	/** Resizes the stack, new elements are zeroed */
+	void SetNum(int32 NewNum)
+	{
+		check(NewNum >= 0 && NewNum <= Capacity);
+		for (int32 i = NumElements; i < NewNum; ++i)
+		{
+			Data[(Head + i) & Mask] = ElementType(0);
+		}
+		NumElements = static_cast<uint8>(NewNum);
+		RebuildFingerprint();
+	}
+
+	/** The elements as up to two contiguous spans, oldest first, so reductions can run as plain loops */
+	void GetSpans(TArrayView<const ElementType>& OutFirst, TArrayView<const ElementType>& OutSecond) const
+	{
+		const int32 FirstNum = FMath::Min<int32>(NumElements, Capacity - Head);
+		OutFirst = MakeArrayView(&Data[Head], FirstNum);
+		OutSecond = MakeArrayView(&Data[0], NumElements - FirstNum);
+	}
+
+	/** View of the newest Count elements, still ordered from oldest to newest */
+	ViewType Newest(int32 Count) const
+	{
+		Count = FMath::Clamp(Count, 0, static_cast<int32>(NumElements));
+		return ViewType(*this, NumElements - Count, Count);
+	}
+
+	/** Replaces the contents of the stack with a view */
+	void Assign(const ViewType& View)
+	{
+		check(View.Num() <= Capacity);
+		ElementType Temp[Capacity];
+		for (int32 i = 0; i < View.Num(); ++i)
+		{
+			Temp[i] = View[i];
+		}
+		FMemory::Memcpy(Data, Temp, View.Num() * sizeof(ElementType));
+		Head = 0;
+		NumElements = static_cast<uint8>(View.Num());
+		RebuildFingerprint();
+	}
+
+	/** Order dependent hash of the elements, equal stacks always have equal fingerprints */
+	uint64 GetFingerprint() const { return Fingerprint; }
+
+	/** Compares the length and fingerprint first, the elements are only compared when both match */
+	bool Equals(const TModifierRingStack& Other) const
+	{
+		if (NumElements != Other.NumElements || Fingerprint != Other.Fingerprint)
+		{
+			return false;
+		}
+		return EqualsElements(Other);
+	}
+
+	bool Equals(const ViewType& Other) const
+	{
+		return EqualsElements(Other);
+	}
+
+	bool operator==(const TModifierRingStack& Other) const { return Equals(Other); }
+	bool operator!=(const TModifierRingStack& Other) const { return !Equals(Other); }
+	bool operator==(const ViewType& Other) const { return Equals(Other); }
+	bool operator!=(const ViewType& Other) const { return !Equals(Other); }
+
+	/** Iterates from oldest to newest */
+	class TConstIterator
+	{
+	public:
+		TConstIterator(const TModifierRingStack& InStack, int32 InIndex)
+			: Stack(InStack)
+			, Index(InIndex)
+		{}
+
+		ElementType operator*() const { return Stack[Index]; }
+		TConstIterator& operator++() { ++Index; return *this; }
+		bool operator!=(const TConstIterator& Other) const { return Index != Other.Index; }
+
+	private:
+		const TModifierRingStack& Stack;
+		int32 Index;
+	};
+
+	TConstIterator begin() const { return TConstIterator(*this, 0); }
+	TConstIterator end() const { return TConstIterator(*this, NumElements); }
+
+private:
+	static constexpr int32 Mask = Capacity - 1;
+
+	/**
+	 * The fingerprint is the polynomial sum of HashElement(Element) * FingerprintBase^Age, modulo 2^64, where the newest element has age 0
+	 * Pushing multiplies by the base, and evicting the oldest subtracts its term, both O(1)
+	 */
+	static constexpr uint64 FingerprintBase = 0x100000001B3ull;
+
+	static constexpr uint64 HashElement(ElementType Element)
+	{
+		return (static_cast<uint64>(Element) + 1) * 0x9E3779B97F4A7C15ull;
+	}
+
+	/** FingerprintBase raised to each age an element can have */
+	struct FPowers
+	{
+		uint64 Values[Capacity];
+
+		constexpr FPowers()
+			: Values()
+		{
+			uint64 Power = 1;
+			for (int32 i = 0; i < Capacity; ++i)
+			{
+				Values[i] = Power;
+				Power *= FingerprintBase;
+			}
+		}
+	};
+	static constexpr FPowers Powers = FPowers();
+
+	template<typename OtherType>
+	bool EqualsElements(const OtherType& Other) const
+	{
+		if (NumElements != Other.Num())
+		{
+			return false;
+		}
+		for (int32 i = 0; i < NumElements; ++i)
+		{
+			if ((*this)[i] != Other[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	ElementType& At(int32 Index)
+	{
+		checkSlow(Index >= 0 && Index < NumElements);
+		return Data[(Head + Index) & Mask];
+	}
+
+	/** Rehashes every element, after removing from the middle of the stack */
+	void RebuildFingerprint()
+	{
+		Fingerprint = 0;
+		for (int32 i = 0; i < NumElements; ++i)
+		{
+			Fingerprint = Fingerprint * FingerprintBase + HashElement(At(i));
+		}
+	}
+
+	ElementType Data[Capacity];
+	uint64 Fingerprint;
+	uint8 Head;
+	uint8 NumElements;
+};
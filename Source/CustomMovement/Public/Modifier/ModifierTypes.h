@@ -9,6 +9,14 @@
 
 #define NO_MODIFIER UINT8_MAX
 
+/**
+ * Number of uniform samples a modifier curve is baked into
+ * @see FModifierCurveLUT
+ */
+#ifndef CM_MODIFIER_CURVE_SAMPLES
+#define CM_MODIFIER_CURVE_SAMPLES 128
+#endif
+
 /**
  * The network type of the modifier, which determines how it is applied and synchronized across clients and servers
  */
@@ -42,6 +50,17 @@ enum class EModifierLevelMethod : uint8
 	Average 			UMETA(ToolTip="The average modifier level will be applied"),
 };
 
+/**
+ * The built-in modifier channels
+ */
+UENUM(BlueprintType)
+enum class EModifierChannel : uint8
+{
+	Haste,
+	Slow,
+	SlowFall,
+};
+
 UENUM(BlueprintType)
 enum class EModifierFallZ : uint8
 {
@@ -108,6 +127,45 @@ struct CUSTOMMOVEMENT_API FMovementModifierParams
 	/** If true, this modifier's MaxWalkSpeed scalar affects root motion translation */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Modifier, meta=(ClampMin="0", UIMin="0", ForceUnits="x"))
 	bool bAffectsRootMotion;
+
+	/** No curves to bake, @see TModifierParamsTable::Rebuild */
+	void BakeCurves() {}
+};
+
+/**
+ * A curve baked into uniform samples over its key range, evaluated with linear interpolation
+ * Evaluation is an index and a lerp, instead of searching and interpolating the curve keys on every call
+ * Curve driven modifier params bake theirs in BakeCurves, which runs whenever the params table is rebuilt
+ */
+struct CUSTOMMOVEMENT_API FModifierCurveLUT
+{
+	/**
+	 * Samples the curve, curves that extrapolate other than constant are left unbaked as clamping would change them
+	 * @return True if the curve was baked
+	 */
+	bool Bake(const FRichCurve& Curve, int32 NumSamples = CM_MODIFIER_CURVE_SAMPLES);
+
+	void Reset()
+	{
+		Samples.Reset();
+	}
+
+	bool IsBaked() const { return Samples.Num() > 0; }
+
+	/** Samples the baked curve, clamped to the key range like constant extrapolation */
+	float Eval(float Time) const
+	{
+		const float Alpha = (FMath::Clamp(Time, MinTime, MaxTime) - MinTime) * InvStep;
+		const int32 Index = FMath::Min(static_cast<int32>(Alpha), Samples.Num() - 2);
+		return FMath::Lerp(Samples[Index], Samples[Index + 1], Alpha - Index);
+	}
+
+private:
+	/** At least two samples once baked, so Eval never needs to check */
+	TArray<float> Samples;
+	float MinTime = 0.f;
+	float MaxTime = 0.f;
+	float InvStep = 0.f;
 };
 
 /**
@@ -162,6 +220,15 @@ struct CUSTOMMOVEMENT_API FFallingModifierParams
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Modifier, meta=(EditCondition="bOverrideAirControl", EditConditionHides))
 	float AirControlOverride;
 
+	/** GravityScalarFallVelocityCurve baked by BakeCurves */
+	FModifierCurveLUT GravityScalarFallVelocityLUT;
+
+	/**
+	 * Validates and bakes GravityScalarFallVelocityCurve, so GetGravityScalar doesn't evaluate the curve
+	 * Called whenever the params table is rebuilt, i.e. when the params are loaded or changed
+	 */
+	void BakeCurves();
+
 	/**
 	 * Get the gravity scalar based on the current velocity.
 	 * If bGravityScalarFromVelocityZ is true, uses GravityScalarFallVelocityCurve to determine the scalar based on Velocity.Z.
@@ -169,11 +236,17 @@ struct CUSTOMMOVEMENT_API FFallingModifierParams
 	 */
 	float GetGravityScalar(const FVector& Velocity) const
 	{
-		if (!ensureMsgf(!bGravityScalarFromVelocityZ || GravityScalarFallVelocityCurve != nullptr, TEXT("GravityScalarFallVelocityCurve must be set")))
+		if (!bGravityScalarFromVelocityZ)
 		{
-			return 1.f;
+			return GravityScalar;
 		}
-		return bGravityScalarFromVelocityZ ? GravityScalarFallVelocityCurve->GetFloatValue(Velocity.Z) : GravityScalar;
+		if (GravityScalarFallVelocityLUT.IsBaked())
+		{
+			return GravityScalarFallVelocityLUT.Eval(Velocity.Z);
+		}
+
+		// Not baked, the curve extrapolates or the params didn't come from the params table
+		return GravityScalarFallVelocityCurve ? GravityScalarFallVelocityCurve->GetFloatValue(Velocity.Z) : 1.f;
 	}
 
 	/**
@@ -188,6 +261,40 @@ struct CUSTOMMOVEMENT_API FFallingModifierParams
 	}
 };
 
+/**
+ * Applies a modifier while the owner's ability system has a gameplay tag, e.g. granted by a gameplay effect
+ * The modifier is added when the tag is gained and removed when it is lost
+ */
+USTRUCT(BlueprintType)
+struct CUSTOMMOVEMENT_API FModifierTagBinding
+{
+	GENERATED_BODY()
+
+	FModifierTagBinding()
+		: Channel(EModifierChannel::Slow)
+		, bServerInitiated(false)
+	{}
+
+	/** The tag owned by the ability system that applies the modifier */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Modifier)
+	FGameplayTag OwnedTag;
+
+	/** The channel the modifier is added to */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Modifier)
+	EModifierChannel Channel;
+
+	/** The level of the modifier, one of the channel's level tags, e.g. CustomMovement.Modifier.Slowdown */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Modifier)
+	FGameplayTag Level;
+
+	/**
+	 * Only bind on the server and push the modifier to the client, for tags that are only added on the server
+	 * Otherwise the client predicts it from its own tags, e.g. a predicted gameplay effect, and is corrected on mismatch
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Modifier)
+	bool bServerInitiated;
+};
+
 /**
  * Client auth parameters for providing client with partial positional authority
  * These parameters can be used to configure how the client can send position updates to the server